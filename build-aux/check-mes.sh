@@ -28,11 +28,19 @@ tests/read.test
 tests/srfi-0.test
 tests/macro.test
 tests/gc.test
+tests/gc-nursery.test
+tests/gc-semispace.test
+tests/gc-los.test
+tests/gc-image.test
+tests/cache.test
+tests/binary.test
+tests/hash.test
 tests/perform.test
 tests/base.test
 tests/quasiquote.test
 tests/let.test
 tests/closure.test
+tests/jit.test
 tests/scm.test
 tests/display.test
 tests/cwv.test
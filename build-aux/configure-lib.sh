@@ -131,6 +131,7 @@ lib/linux/lseek.c
     fi
 else
     libmes_SOURCES="$libmes_SOURCES
+lib/mes/__buffered_read.c
 lib/mes/abtod.c
 lib/mes/dtoab.c
 "
@@ -433,7 +434,9 @@ lib/linux/symlink.c
 fi
 
 mes_SOURCES="
+src/binary.c
 src/builtins.c
+src/cache.c
 src/cc.c
 src/core.c
 src/display.c
@@ -441,6 +444,7 @@ src/eval-apply.c
 src/gc.c
 src/globals.c
 src/hash.c
+src/jit.c
 src/lib.c
 src/math.c
 src/mes.c
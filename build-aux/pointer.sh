@@ -49,7 +49,9 @@ sed -ri                                                         \
     include/mes/symbols.h                                       \
     include/mes/builtins.h                                      \
     include/m2/lib.h                                            \
+    src/binary.c                                                \
     src/builtins.c                                              \
+    src/cache.c                                                 \
     src/cc.c                                                    \
     src/core.c                                                  \
     src/display.c                                               \
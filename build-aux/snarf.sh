@@ -24,6 +24,7 @@ srcdest=${srcdest-./}
 . ${srcdest}config.sh
 . ${srcdest}build-aux/trace.sh
 
+trace "SNARF$snarf  binary.c"     ${srcdest}build-aux/mes-snarf.scm src/binary.c
 trace "SNARF$snarf  builtins.c"   ${srcdest}build-aux/mes-snarf.scm src/builtins.c
 trace "SNARF$snarf  core.c"       ${srcdest}build-aux/mes-snarf.scm src/core.c
 trace "SNARF$snarf  display.c"    ${srcdest}build-aux/mes-snarf.scm src/display.c
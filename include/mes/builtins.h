@@ -21,6 +21,9 @@
 #ifndef __MES_BUILTINS_H
 #define __MES_BUILTINS_H
 
+/* src/binary.c */
+struct scm *write_binary (struct scm *x);
+struct scm *read_binary (struct scm *port);
 /* src/builtins.c */
 struct scm *make_builtin (struct scm *builtin_type, struct scm *name, struct scm *arity, struct scm *function);
 struct scm *builtin_name (struct scm *builtin);
@@ -61,6 +64,7 @@ struct scm *gc_stats ();
 struct scm *cons (struct scm *x, struct scm *y);
 struct scm *gc_check ();
 struct scm *gc ();
+struct scm *dump_image (struct scm *file_name);
 /* src/hash.c */
 struct scm *hashq (struct scm *x, struct scm *size);
 struct scm *hash (struct scm *x, struct scm *size);
@@ -69,6 +73,7 @@ struct scm *hashq_ref (struct scm *table, struct scm *key, struct scm *dflt);
 struct scm *hash_ref (struct scm *table, struct scm *key, struct scm *dflt);
 struct scm *hashq_set_x (struct scm *table, struct scm *key, struct scm *value);
 struct scm *hash_set_x (struct scm *table, struct scm *key, struct scm *value);
+struct scm *hash_count (struct scm *table);
 struct scm *hash_table_printer (struct scm *table);
 struct scm *make_hash_table (struct scm *x);
 /* src/lib.c */
@@ -119,6 +124,9 @@ struct scm *access_p (struct scm *file_name, struct scm *mode);
 struct scm *current_input_port ();
 struct scm *open_input_file (struct scm *file_name);
 struct scm *open_input_string (struct scm *string);
+struct scm *open_output_string ();
+struct scm *get_output_string (struct scm *port);
+struct scm *close_port (struct scm *port);
 struct scm *set_current_input_port (struct scm *port);
 struct scm *current_output_port ();
 struct scm *current_error_port ();
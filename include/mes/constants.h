@@ -60,6 +60,8 @@
 #define TVECTOR           16
 // CONSTANT TBROKEN_HEART 17
 #define TBROKEN_HEART     17
+// CONSTANT TLEXICAL      18
+#define TLEXICAL          18
 
 /* Struct types */
 
@@ -73,6 +75,9 @@
 // CONSTANT GC_FRAME_PROCEDURE 4
 #define GC_FRAME_PROCEDURE 4
 
+// CONSTANT EXPANDED_SIZE 1024
+#define EXPANDED_SIZE 1024
+
 // CONSTANT STDIN 0
 // CONSTANT STDOUT 1
 // CONSTANT STDERR 2
@@ -66,11 +66,22 @@ extern void (*__call_at_exit) (void);
 
 #define __FILEDES_MAX 512
 
+/* The read buffer of a file descriptor: the bytes from POS up to SIZE
+   of STRING have not been read yet.  */
+struct __read_buffer
+{
+  char *string;
+  ssize_t size;
+  ssize_t pos;
+};
+
+extern struct __read_buffer *__read_cache;
+ssize_t __buffered_read (int filedes, void *buffer, size_t size);
+size_t __buffered_read_clear (int filedes);
+
 #if !SYSTEM_LIBC
 void __assert_fail (char const *s, char const *file, unsigned line,
                     char const *function);
-ssize_t __buffered_read (int filedes, void *buffer, size_t size);
-size_t __buffered_read_clear (int filedes);
 void _exit (int code);
 long brk (void *addr);
 #endif // !SYSTEM_LIBC
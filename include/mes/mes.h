@@ -24,9 +24,21 @@
 #include <sys/types.h>
 #include "mes/cc.h"
 
+/* The baseline JIT of jit.c emits x86_64 code, in a build with the
+   system libc.  */
+#if SYSTEM_LIBC && __x86_64__ && !MES_COMPACT_CELLS
+#define MES_HAVE_JIT 1
+#endif
+
+/* A cell is three words: the type and two data words.  With
+   MES_COMPACT_CELLS, a gcc-only build option, a cell is two words and
+   its type is a byte in the side table g_cell_types, see gc_init.  Use
+   cell_type and set_cell_type to get at the type.  */
 struct scm
 {
+#if !MES_COMPACT_CELLS
   long type;
+#endif
   union
   {
     struct scm *car;
@@ -74,7 +86,25 @@ extern struct scm *R3;
 extern struct scm *M0;
 /* macro */
 extern struct scm *g_macros;
+extern struct scm **g_expanded;
+extern long g_expanded_count;
+/* (current-input current-output argument) ports */
 extern struct scm *g_ports;
+extern int g_port_count;
+/* the constants of the functions compiled by the JIT */
+extern struct scm *g_jit_constants;
+#if MES_HAVE_JIT
+extern int g_jit;
+#endif
+
+/* binary */
+extern char *binary_buffer;
+extern long binary_size;
+extern long binary_input_pos;
+extern int binary_error;
+
+/* cache */
+extern char *cache_directory;
 
 /* gc */
 extern size_t ARENA_SIZE;
@@ -83,6 +113,9 @@ extern size_t STACK_SIZE;
 extern size_t JAM_SIZE;
 extern size_t GC_SAFETY;
 extern size_t MAX_STRING;
+extern size_t NURSERY_SIZE;
+extern size_t REMEMBERED_SIZE;
+extern size_t LOS_THRESHOLD;
 extern char *g_arena;
 extern struct scm *cell_arena;
 extern struct scm *cell_zero;
@@ -93,8 +126,12 @@ extern struct scm *g_symbol;
 extern struct scm **g_stack_array;
 extern struct scm *g_cells;
 extern struct scm *g_news;
+extern struct scm *g_nursery;
+extern struct scm **g_remembered_set;
+extern long g_remembered;
 extern long g_stack;
 extern size_t gc_count;
+extern size_t gc_minor_count;
 extern struct timespec *gc_start_time;
 extern struct timespec *gc_end_time;
 extern size_t gc_time;
@@ -108,6 +145,17 @@ extern struct timespec *g_start_time;
 extern struct timeval *__gettimeofday_time;
 extern struct timespec *__get_internal_run_time_ts;
 
+long cell_type (struct scm *x);
+void set_cell_type (struct scm *x, long type);
+#if MES_COMPACT_CELLS
+extern char *g_cell_types;
+#define cell_type(x) (g_cell_types[(unsigned long) (x) / sizeof (struct scm)])
+#define set_cell_type(x, t) (g_cell_types[(unsigned long) (x) / sizeof (struct scm)] = (t))
+#elif !__M2_PLANET__
+#define cell_type(x) ((x)->type)
+#define set_cell_type(x, t) ((x)->type = (t))
+#endif
+
 struct scm *cast_charp_to_scmp (char const *i);
 struct scm **cast_charp_to_scmpp (char const *i);
 char *cast_voidp_to_charp (void const *i);
@@ -121,11 +169,17 @@ struct scm *apply_builtin0 (struct scm *fn);
 struct scm *apply_builtin1 (struct scm *fn, struct scm *x);
 struct scm *apply_builtin2 (struct scm *fn, struct scm *x, struct scm *y);
 struct scm *apply_builtin3 (struct scm *fn, struct scm *x, struct scm *y, struct scm *z);
+struct scm *binary_make_string (char const *s, long length);
+struct scm *binary_read_ ();
 struct scm *builtin_name (struct scm *builtin);
+struct scm *cache_load (struct scm *file_name);
+struct scm *cache_sources (struct scm *forms);
 struct scm *cstring_to_list (char const *s);
 struct scm *cstring_to_symbol (char const *s);
 struct scm *cell_ref (struct scm *cell, long index);
 struct scm *fdisplay_ (struct scm *, int, int);
+struct scm *gc_minor ();
+struct scm *gc_scan (struct scm *scan);
 struct scm *init_symbols ();
 struct scm *init_time (struct scm *a);
 struct scm *make_builtin_type ();
@@ -135,42 +189,76 @@ struct scm *make_pointer_cell (long type, long car, void *cdr);
 struct scm *make_value_cell (long type, long car, long cdr);
 struct scm *make_char (int n);
 struct scm *make_continuation (long n);
+struct scm *hash_ref_bytes (struct scm *table, char const *s, size_t length);
 struct scm *make_hash_table_ (long size);
 struct scm *make_hashq_type ();
 struct scm *make_initial_module (struct scm *a);
+struct scm *macro_get_handle (struct scm *name);
 struct scm *make_macro (struct scm *name, struct scm *x);
 struct scm *make_number (long n);
 struct scm *make_ref (struct scm *x);
 struct scm *make_string (char const *s, size_t length);
 struct scm *make_string0 (char const *s);
 struct scm *make_string_port (struct scm *x);
+struct scm *make_string_output_port ();
 struct scm *make_vector_ (long k, struct scm *e);
 struct scm *mes_builtins (struct scm *a);
+struct scm *port_ref (long port);
 struct scm *push_cc (struct scm *p1, struct scm *p2, struct scm *a, struct scm *c);
 struct scm *struct_ref_ (struct scm *x, long i);
 struct scm *struct_set_x_ (struct scm *x, long i, struct scm *e);
 struct scm *vector_ref_ (struct scm *x, long i);
 struct scm *vector_set_x_ (struct scm *x, long i, struct scm *e);
+long builtin_arity_ (struct scm *builtin);
 FUNCTION builtin_function (struct scm *builtin);
 char *cell_bytes (struct scm *x);
+char *port_bytes (struct scm *data);
+int binary_port_write (char const *s, long length, int fd);
+int binary_write_ (struct scm *x);
 int peekchar ();
 int readchar ();
 int unreadchar ();
+int port_argument (struct scm *port);
+int port_putc (int c, int fd);
+int port_puts (char const *s, int fd);
+int port_write (char const *s, int length, int fd);
 long gc_free ();
+long binary_get_number ();
 long length__ (struct scm *x);
 size_t bytes_cells (size_t length);
+unsigned hash_bytes (char const *s, size_t length);
 void assert_max_string (size_t i, char const *msg, char const *string);
 void assert_msg (int check, char *msg);
 void assert_number (char const *name, struct scm *x);
+void binary_put_number (long n);
+void binary_read_init (char const *s, long length);
+void binary_write_init ();
+void cache_end (struct scm *state);
+void cache_init ();
+void cache_record (struct scm *x);
+void cache_source (struct scm *x);
 void copy_cell (struct scm *to, struct scm *from);
 void gc_ ();
 void gc_dump_arena (struct scm *cells, long size);
 void gc_init ();
+void gc_load_image (char const *file_name);
+void gc_init_cache ();
+void gc_clear_expanded ();
+void gc_los_relocate (struct scm *h);
 void gc_peek_frame ();
 void gc_pop_frame ();
+struct scm *gc_relocate (struct scm *x);
 void gc_push_frame ();
 void gc_stats_ (char const* where);
+void gc_grow_arena (long i, char *msg);
+void gc_up_arena ();
+void gc_write_barrier (struct scm *x);
 void init_symbols_ ();
+#if MES_HAVE_JIT
+struct scm *jit_apply ();
+void jit_init ();
+#endif
+void port_unmap (struct scm *port);
 long seconds_and_nanoseconds_to_long (long s, long ns);
 
 #include "mes/builtins.h"
@@ -30,6 +30,9 @@ extern struct scm *cell_undefined;
 extern struct scm *cell_unspecified;
 extern struct scm *cell_closure;
 extern struct scm *cell_circular;
+extern struct scm *cell_cache_end;
+extern struct scm *cell_cache_form;
+extern struct scm *cell_cache_source;
 
 extern struct scm *cell_vm_apply;
 extern struct scm *cell_vm_apply2;
@@ -42,13 +45,18 @@ extern struct scm *cell_vm_begin_expand_primitive_load;
 extern struct scm *cell_vm_begin_primitive_load;
 extern struct scm *cell_vm_begin_read_input_file;
 extern struct scm *cell_vm_call_with_current_continuation2;
+extern struct scm *cell_vm_call_with_escape_continuation2;
 extern struct scm *cell_vm_call_with_values2;
 extern struct scm *cell_vm_eval;
 extern struct scm *cell_vm_eval2;
+extern struct scm *cell_vm_eval_and;
+extern struct scm *cell_vm_eval_case;
 extern struct scm *cell_vm_eval_check_func;
+extern struct scm *cell_vm_eval_cond;
 extern struct scm *cell_vm_eval_define;
 extern struct scm *cell_vm_eval_macro_expand_eval;
 extern struct scm *cell_vm_eval_macro_expand_expand;
+extern struct scm *cell_vm_eval_or;
 extern struct scm *cell_vm_eval_pmatch_car;
 extern struct scm *cell_vm_eval_pmatch_cdr;
 extern struct scm *cell_vm_eval_set_x;
@@ -59,6 +67,8 @@ extern struct scm *cell_vm_if;
 extern struct scm *cell_vm_if_expr;
 extern struct scm *cell_vm_macro_expand;
 extern struct scm *cell_vm_macro_expand_car;
+extern struct scm *cell_vm_macro_expand_case;
+extern struct scm *cell_vm_macro_expand_case_clause;
 extern struct scm *cell_vm_macro_expand_cdr;
 extern struct scm *cell_vm_macro_expand_define;
 extern struct scm *cell_vm_macro_expand_define_macro;
@@ -80,12 +90,17 @@ extern struct scm *cell_symbol_quasisyntax;
 extern struct scm *cell_symbol_unsyntax;
 extern struct scm *cell_symbol_unsyntax_splicing;
 extern struct scm *cell_symbol_set_x;
+extern struct scm *cell_symbol_and;
+extern struct scm *cell_symbol_or;
+extern struct scm *cell_symbol_cond;
+extern struct scm *cell_symbol_case;
 extern struct scm *cell_symbol_sc_expand;
 extern struct scm *cell_symbol_macro_expand;
 extern struct scm *cell_symbol_portable_macro_expand;
 extern struct scm *cell_symbol_sc_expander_alist;
 extern struct scm *cell_symbol_call_with_values;
 extern struct scm *cell_symbol_call_with_current_continuation;
+extern struct scm *cell_symbol_call_with_escape_continuation;
 extern struct scm *cell_symbol_boot_module;
 extern struct scm *cell_symbol_current_module;
 extern struct scm *cell_symbol_primitive_load;
@@ -99,6 +114,8 @@ extern struct scm *cell_symbol_unbound_variable;
 extern struct scm *cell_symbol_wrong_number_of_args;
 extern struct scm *cell_symbol_wrong_type_arg;
 extern struct scm *cell_symbol_buckets;
+extern struct scm *cell_symbol_epoch;
+extern struct scm *cell_symbol_count;
 extern struct scm *cell_symbol_builtin;
 extern struct scm *cell_symbol_frame;
 extern struct scm *cell_symbol_hashq_table;
@@ -134,17 +151,18 @@ extern struct scm *cell_type_values;
 extern struct scm *cell_type_variable;
 extern struct scm *cell_type_vector;
 extern struct scm *cell_type_broken_heart;
+extern struct scm *cell_type_lexical;
 extern struct scm *cell_symbol_program;
 extern struct scm *cell_symbol_test;
 
-// CONSTANT SYMBOL_MAX 114
-#define SYMBOL_MAX 114
+// CONSTANT SYMBOL_MAX 132
+#define SYMBOL_MAX 132
 
 // CONSTANT CELL_UNSPECIFIED 7
 #define CELL_UNSPECIFIED 7
 
-// CONSTANT CELL_SYMBOL_RECORD_TYPE 82
-#define CELL_SYMBOL_RECORD_TYPE 82
+// CONSTANT CELL_SYMBOL_RECORD_TYPE 99
+#define CELL_SYMBOL_RECORD_TYPE 99
 
 
 #endif /* __MES_SYMBOLS_H */
@@ -22,20 +22,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if SYSTEM_LIBC
+#include <unistd.h>
+#define _read read
+#endif
+
+/* The default size of the read buffer of a file descriptor, which
+   MES_READ_BUFFER overrides.  */
 #if !__MESC__
-#define __READ_BUFFER_MAX 128
+#define __READ_BUFFER_SIZE 4096
 int __read_buffer_max;
 #else /* FIXME: We want bin/mes-mescc's x86-linux sha256sum to stay the same. */
-#define __READ_BUFFER_MAX 100
+#define __READ_BUFFER_SIZE 100
 #define __read_buffer_max 100
 #endif
 
-struct __read_buffer
-{
-  ssize_t size;
-  char string[__READ_BUFFER_MAX];
-};
-
 struct __read_buffer *__read_cache = 0;
 
 void
@@ -44,16 +45,15 @@ __buffered_read_init (int filedes)
   if (!__read_cache)
     {
       __read_cache = (struct __read_buffer *) malloc (sizeof (struct __read_buffer) * __FILEDES_MAX);
+      memset (__read_cache, 0, sizeof (struct __read_buffer) * __FILEDES_MAX);
 #if !__MESC__
-      __read_buffer_max = __READ_BUFFER_MAX;
+      __read_buffer_max = __READ_BUFFER_SIZE;
       char *p = getenv ("MES_READ_BUFFER");
       if (p)
         {
           __read_buffer_max = atoi (p);
           if (__read_buffer_max < 0)
             __read_buffer_max = 0;
-          if (__read_buffer_max > __READ_BUFFER_MAX)
-            __read_buffer_max = __READ_BUFFER_MAX;
         }
 #endif
     }
@@ -63,47 +63,60 @@ size_t
 __buffered_read_clear (int filedes)
 {
   __buffered_read_init (filedes);
-  size_t size = __read_cache[filedes].size;
-  __read_cache[filedes].size = 0;
+  struct __read_buffer *cache = &__read_cache[filedes];
+  size_t size = cache->size - cache->pos;
+  cache->size = 0;
+  cache->pos = 0;
   return size;
 }
 
 ssize_t
 __buffered_read (int filedes, void *buffer, size_t size)
 {
-  size_t todo = size;
   __buffered_read_init (filedes);
   struct __read_buffer *cache = &__read_cache[filedes];
   char *p = buffer;
-  if (!cache->size && size > __read_buffer_max)
-    return _read (filedes, buffer, size);
-  while (cache->size > 0 && todo)
+  size_t done = cache->size - cache->pos;
+  if (done > size)
+    done = size;
+  if (done)
     {
-      todo--;
-      *p++ = cache->string[__read_buffer_max - cache->size--];
+      memcpy (p, cache->string + cache->pos, done);
+      cache->pos += done;
+      if (done == size)
+        return size;
+      p += done;
     }
-  if (todo)
+  size_t todo = size - done;
+  ssize_t bytes;
+  if (todo >= __read_buffer_max)
     {
-#if !__MESC__
-      if (todo > __read_buffer_max)
-        return size - todo + _read (filedes, p, todo);
-      if (__mes_debug () > 4)
-        {
-          eputs ("__buffered_read: ");
-          eputs (itoa (__read_buffer_max));
-          eputs ("\n");
-        }
-#endif
-      ssize_t bytes = _read (filedes, cache->string, __read_buffer_max);
+      bytes = _read (filedes, p, todo);
       if (bytes < 0)
-        return -1;
-      if (bytes)
-        {
-          cache->size = bytes;
-          if (bytes < __read_buffer_max)
-            memmove (cache->string + __read_buffer_max - bytes, cache->string, bytes);
-          return size - todo + __buffered_read (filedes, p, todo);
-        }
+        return done ? done : -1;
+      return done + bytes;
+    }
+  if (!cache->string)
+    cache->string = malloc (__read_buffer_max);
+#if !__MESC__ && !SYSTEM_LIBC
+  if (__mes_debug () > 4)
+    {
+      eputs ("__buffered_read: ");
+      eputs (itoa (__read_buffer_max));
+      eputs ("\n");
+    }
+#endif
+  bytes = _read (filedes, cache->string, __read_buffer_max);
+  cache->size = 0;
+  cache->pos = 0;
+  if (bytes < 0)
+    return done ? done : -1;
+  if (bytes > todo)
+    {
+      cache->size = bytes;
+      cache->pos = todo;
+      bytes = todo;
     }
-  return size - todo;
+  memcpy (p, cache->string, bytes);
+  return done + bytes;
 }
@@ -74,6 +74,21 @@ fdgetc (int fd)
   int i = __ungetc_buf[fd];
   if (i >= 0)
     __ungetc_buf[fd] = -1;
+#if !__M2_PLANET__
+  else if (__read_cache != 0 && __read_cache[fd].pos < __read_cache[fd].size)
+    {
+      struct __read_buffer *cache = &__read_cache[fd];
+      i = cache->string[cache->pos];
+      cache->pos = cache->pos + 1;
+    }
+  else
+    {
+      int r = __buffered_read (fd, &c, 1);
+      if (r < 1)
+        return -1;
+      i = c;
+    }
+#else
   else
     {
       int r = read (fd, &c, 1);
@@ -81,6 +96,7 @@ fdgetc (int fd)
         return -1;
       i = c;
     }
+#endif
   if (i < 0)
     i = i + 256;
 
@@ -34,7 +34,10 @@ mes_open (char const *file_name, int flags, int mask)
 {
   int filedes = open (file_name, flags, mask);
   if (filedes > 2)
-    __ungetc_clear (filedes);
+    {
+      __ungetc_clear (filedes);
+      __buffered_read_clear (filedes);
+    }
   return filedes;
 }
 
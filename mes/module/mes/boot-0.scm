@@ -53,7 +53,8 @@
       (core:write-port x (car rest))))
 
 (define (newline . rest)
-  (core:display "\n"))
+  (if (null? rest) (core:display "\n")
+      (core:display-port "\n" (car rest))))
 
 (define (cadr x) (car (cdr x)))
 
@@ -205,7 +206,6 @@
 (mes-use-module (mes getopt-long))
 
 (define %main #f)
-(primitive-load 0)
 (let ((tty? (isatty? 0)))
   (define (parse-opts args)
     (let* ((option-spec
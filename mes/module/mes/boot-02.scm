@@ -53,7 +53,8 @@
       (core:write-port x (car rest))))
 
 (define (newline . rest)
-  (core:display "\n"))
+  (if (null? rest) (core:display "\n")
+      (core:display-port "\n" (car rest))))
 
 (define (cadr x) (car (cdr x)))
 
@@ -80,20 +81,6 @@
 ;; end boot-01.scm
 
 ;; boot-02.scm
-(define-macro (and . x)
-  (if (null? x) #t
-      (if (null? (cdr x)) (car x)
-          (list (quote if) (car x) (cons (quote and) (cdr x))
-                #f))))
-
-(define-macro (or . x)
-  (if (null? x) #f
-      (if (null? (cdr x)) (car x)
-          (list (list (quote lambda) (list (quote r))
-                      (list (quote if) (quote r) (quote r)
-                            (cons (quote or) (cdr x))))
-                (car x)))))
-
 (define-macro (mes-use-module module)
   #t)
 
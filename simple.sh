@@ -44,6 +44,7 @@ gcc -g -D HAVE_CONFIG_H=1                       \
     lib/mes/eputs.c                             \
     lib/mes/oputs.c                             \
                                                 \
+    lib/mes/__buffered_read.c                   \
     lib/mes/cast.c                              \
     lib/mes/itoa.c                              \
     lib/mes/ltoa.c                              \
@@ -62,7 +63,9 @@ gcc -g -D HAVE_CONFIG_H=1                       \
     lib/mes/__assert_fail.c                     \
     lib/mes/assert_msg.c                        \
                                                 \
+    src/binary.c                                \
     src/builtins.c                              \
+    src/cache.c                                 \
     src/cc.c                                    \
     src/core.c                                  \
     src/display.c                               \
@@ -70,6 +73,7 @@ gcc -g -D HAVE_CONFIG_H=1                       \
     src/gc.c                                    \
     src/globals.c                               \
     src/hash.c                                  \
+    src/jit.c                                   \
     src/lib.c                                   \
     src/math.c                                  \
     src/mes.c                                   \
@@ -266,7 +270,9 @@ $CC -g -D HAVE_CONFIG_H=1                               \
     lib/linux/waitpid.c                                 \
     lib/linux/$mes_cpu-mes-$compiler/syscall.c          \
                                                         \
+    src/binary.c                                        \
     src/builtins.c                                      \
+    src/cache.c                                         \
     src/cc.c                                            \
     src/core.c                                          \
     src/display.c                                       \
@@ -274,6 +280,7 @@ $CC -g -D HAVE_CONFIG_H=1                               \
     src/gc.c                                            \
     src/globals.c                                       \
     src/hash.c                                          \
+    src/jit.c                                           \
     src/lib.c                                           \
     src/math.c                                          \
     src/mes.c                                           \
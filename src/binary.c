@@ -0,0 +1,537 @@
+/* -*-comment-start: "//";comment-end:""-*-
+ * GNU Mes --- Maxwell Equations of Software
+ * Copyright © 2026 agent <agent@local>
+ *
+ * This file is part of GNU Mes.
+ *
+ * GNU Mes is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * GNU Mes is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Mes.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mes/lib.h"
+#include "mes/mes.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Binary s-expressions.  Every datum starts with a tag byte; lengths,
+   numbers and characters follow as base-128 varints:
+
+     (        ()                    f   #f
+     t        #t                    l   N datum... tail: a list of N pairs
+     y        N byte...: a symbol   k   N byte...: a keyword
+     s        N byte...: a string   v   N datum...: a vector
+     n        N: a number           m   N: the number -N - 1
+     c        N: a character        e   N: the character -N - 1
+     r        N: the Nth object of the stream
+
+   Symbols, strings, vectors and pairs are numbered in the order that
+   they are written, the pairs of a list before its elements, so that
+   an object that is written again, such as a symbol or a shared or
+   circular structure, is written as a reference.  Special cells are
+   written as symbols.  Other objects, such as procedures and ports,
+   cannot be written.
+
+   On a port, write-binary precedes a datum with its size, so that
+   read-binary reads it in one go.  */
+
+// CONSTANT BINARY_MAX 67108864
+#define BINARY_MAX 67108864
+
+long binary_max;
+struct scm *binary_objects;
+long binary_object_count;
+
+char const *binary_input;
+long binary_input_size;
+struct scm **binary_table;
+long binary_table_count;
+long binary_table_max;
+
+char *binary_port_buffer;
+long binary_port_max;
+
+void
+binary_putc (int c)
+{
+  if (binary_size == binary_max)
+    {
+      binary_max = binary_max * 2;
+      binary_buffer = realloc (binary_buffer, binary_max);
+    }
+  binary_buffer[binary_size] = c;
+  binary_size = binary_size + 1;
+}
+
+void
+binary_put_bytes (char const *s, long length)
+{
+  long i;
+  for (i = 0; i < length; i = i + 1)
+    binary_putc (s[i]);
+}
+
+void
+binary_put_number (long n)
+{
+  while (n >= 128)
+    {
+      binary_putc (128 + (n % 128));
+      n = n / 128;
+    }
+  binary_putc (n);
+}
+
+/* Start a new stream in the output buffer.  */
+void
+binary_write_init ()
+{
+  if (binary_buffer == 0)
+    {
+      binary_max = 4096;
+      binary_buffer = malloc (binary_max);
+    }
+  binary_size = 0;
+  binary_objects = make_hash_table_ (0);
+  binary_object_count = 0;
+}
+
+/* Number X, or write a reference and return 1 if X was written
+   before.  */
+int
+binary_write_ref (struct scm *x)        /*:((internal)) */
+{
+  struct scm *index = hashq_ref (binary_objects, x, cell_f);
+  if (index != cell_f)
+    {
+      binary_putc ('r');
+      binary_put_number (index->value);
+      return 1;
+    }
+  hashq_set_x (binary_objects, x, make_number (binary_object_count));
+  binary_object_count = binary_object_count + 1;
+  return 0;
+}
+
+/* Append X to the output buffer; return -1 if X cannot be written.  */
+int
+binary_write_ (struct scm *x)
+{
+  if (binary_size > BINARY_MAX)
+    return -1;
+  long t = cell_type (x);
+  long n;
+  long i;
+  struct scm *y;
+  if (x == cell_nil)
+    binary_putc ('(');
+  else if (x == cell_f)
+    binary_putc ('f');
+  else if (x == cell_t)
+    binary_putc ('t');
+  else if (t == TPAIR)
+    {
+      if (binary_write_ref (x) != 0)
+        return 0;
+      /* Number the pairs up to one that was written before.  */
+      n = 1;
+      y = x->cdr;
+      while (cell_type (y) == TPAIR && hashq_ref (binary_objects, y, cell_f) == cell_f)
+        {
+          binary_write_ref (y);
+          n = n + 1;
+          y = y->cdr;
+        }
+      binary_putc ('l');
+      binary_put_number (n);
+      for (i = 0; i < n; i = i + 1)
+        {
+          if (binary_write_ (x->car) != 0)
+            return -1;
+          x = x->cdr;
+        }
+      return binary_write_ (x);
+    }
+  else if (t == TSYMBOL || t == TSPECIAL || t == TSTRING)
+    {
+      if (binary_write_ref (x) != 0)
+        return 0;
+      if (t == TSTRING)
+        binary_putc ('s');
+      else
+        binary_putc ('y');
+      binary_put_number (x->length);
+      binary_put_bytes (cell_bytes (x->string), x->length);
+    }
+  else if (t == TKEYWORD)
+    {
+      binary_putc ('k');
+      binary_put_number (x->length);
+      binary_put_bytes (cell_bytes (x->string), x->length);
+    }
+  else if (t == TNUMBER)
+    {
+      n = x->value;
+      if (n < 0)
+        {
+          binary_putc ('m');
+          n = -(n + 1);
+        }
+      else
+        binary_putc ('n');
+      binary_put_number (n);
+    }
+  else if (t == TCHAR)
+    {
+      n = x->value;
+      if (n < 0)
+        {
+          binary_putc ('e');
+          n = -(n + 1);
+        }
+      else
+        binary_putc ('c');
+      binary_put_number (n);
+    }
+  else if (t == TVECTOR)
+    {
+      if (binary_write_ref (x) != 0)
+        return 0;
+      binary_putc ('v');
+      binary_put_number (x->length);
+      for (i = 0; i < x->length; i = i + 1)
+        if (binary_write_ (vector_ref_ (x, i)) != 0)
+          return -1;
+    }
+  else
+    return -1;
+  return 0;
+}
+
+/* Make a string of the LENGTH bytes at S, which need not be followed
+   by a null byte.  */
+struct scm *
+binary_make_string (char const *s, long length)
+{
+  struct scm *x = make_string (0, length);
+  char *p = cell_bytes (x->string);
+  memcpy (p, s, length);
+  p[length] = 0;
+  return x;
+}
+
+/* Start reading the LENGTH bytes at S.  */
+void
+binary_read_init (char const *s, long length)
+{
+  binary_input = s;
+  binary_input_size = length;
+  binary_input_pos = 0;
+  binary_table_count = 0;
+  binary_error = 0;
+  if (binary_table == 0)
+    {
+      binary_table_max = 256;
+      binary_table = malloc (binary_table_max * sizeof (struct scm *));
+    }
+}
+
+int
+binary_getc ()
+{
+  if (binary_input_pos >= binary_input_size)
+    {
+      binary_error = 1;
+      return 0;
+    }
+  int c = binary_input[binary_input_pos];
+  binary_input_pos = binary_input_pos + 1;
+  return (0x100 + c) % 0x100;
+}
+
+long
+binary_get_number ()
+{
+  long n = 0;
+  long scale = 1;
+  int c = binary_getc ();
+  while (c >= 128)
+    {
+      n = n + ((c - 128) * scale);
+      scale = scale * 128;
+      c = binary_getc ();
+    }
+  return n + (c * scale);
+}
+
+/* Return the next LENGTH bytes of input, or 0 when there are fewer.  */
+char const *
+binary_get_bytes (long length)
+{
+  if (length < 0 || length > binary_input_size - binary_input_pos)
+    {
+      binary_error = 1;
+      return 0;
+    }
+  char const *s = binary_input + binary_input_pos;
+  binary_input_pos = binary_input_pos + length;
+  return s;
+}
+
+/* Number X, the next object of the stream.  */
+struct scm *
+binary_read_ref (struct scm *x)         /*:((internal)) */
+{
+  if (binary_table_count == binary_table_max)
+    {
+      binary_table_max = binary_table_max * 2;
+      binary_table = realloc (binary_table, binary_table_max * sizeof (struct scm *));
+    }
+  binary_table[binary_table_count] = x;
+  binary_table_count = binary_table_count + 1;
+  return x;
+}
+
+/* Read the next datum; on malformed input, set binary_error.  */
+struct scm *
+binary_read_ ()
+{
+  if (binary_error != 0)
+    return cell_unspecified;
+  int c = binary_getc ();
+  long n;
+  long i;
+  char const *s;
+  struct scm *x;
+  struct scm *y;
+  struct scm *p;
+  if (c == '(')
+    return cell_nil;
+  if (c == 'f')
+    return cell_f;
+  if (c == 't')
+    return cell_t;
+  if (c == 'l')
+    {
+      n = binary_get_number ();
+      if (n < 1 || n > binary_input_size - binary_input_pos)
+        {
+          binary_error = 1;
+          return cell_unspecified;
+        }
+      x = binary_read_ref (cons (cell_unspecified, cell_nil));
+      p = x;
+      for (i = 1; i < n; i = i + 1)
+        {
+          y = binary_read_ref (cons (cell_unspecified, cell_nil));
+          p->cdr = y;
+          p = y;
+        }
+      y = x;
+      for (i = 0; i < n; i = i + 1)
+        {
+          y->car = binary_read_ ();
+          y = y->cdr;
+        }
+      p->cdr = binary_read_ ();
+      return x;
+    }
+  if (c == 'r')
+    {
+      n = binary_get_number ();
+      if (n < binary_table_count)
+        return binary_table[n];
+      binary_error = 1;
+      return cell_unspecified;
+    }
+  if (c == 'y' || c == 'k' || c == 's')
+    {
+      n = binary_get_number ();
+      s = binary_get_bytes (n);
+      if (s == 0)
+        return cell_unspecified;
+      if (c == 'y')
+        {
+          x = hash_ref_bytes (g_symbols, s, n);
+          if (x == cell_f)
+            x = make_symbol (binary_make_string (s, n));
+          return binary_read_ref (x);
+        }
+      x = binary_make_string (s, n);
+      if (c == 'k')
+        set_cell_type (x, TKEYWORD);
+      else
+        binary_read_ref (x);
+      return x;
+    }
+  if (c == 'n')
+    return make_number (binary_get_number ());
+  if (c == 'm')
+    return make_number (-binary_get_number () - 1);
+  if (c == 'c')
+    return make_char (binary_get_number ());
+  if (c == 'e')
+    return make_char (-binary_get_number () - 1);
+  if (c == 'v')
+    {
+      n = binary_get_number ();
+      if (n > binary_input_size - binary_input_pos)
+        {
+          binary_error = 1;
+          return cell_unspecified;
+        }
+      x = binary_read_ref (make_vector_ (n, cell_unspecified));
+      for (i = 0; i < n && binary_error == 0; i = i + 1)
+        vector_set_x_ (x, i, binary_read_ ());
+      return x;
+    }
+  binary_error = 1;
+  return cell_unspecified;
+}
+
+int
+binary_port_write (char const *s, long length, int fd)  /*:((internal)) */
+{
+  int r;
+  while (length > 0)
+    {
+      r = port_write (s, length, fd);
+      if (r <= 0)
+        return -1;
+      s = s + r;
+      length = length - r;
+    }
+  return 0;
+}
+
+/* Return the next LENGTH bytes of the current input port, or 0 when
+   there are fewer.  */
+char const *
+binary_port_read (long length)  /*:((internal)) */
+{
+  char const *p;
+  if (__stdin < 0)
+    {
+      struct scm *port = g_ports->car;
+      struct scm *data = port->cdr->car;
+      struct scm *cursor = port->cdr->cdr;
+      if (length > data->length - cursor->value)
+        {
+          if (cursor->value == data->length)
+            port_unmap (port);
+          return 0;
+        }
+      p = port_bytes (data);
+      p = p + cursor->value;
+      cursor->value = cursor->value + length;
+      return p;
+    }
+  if (length > binary_port_max)
+    {
+      binary_port_max = length;
+      if (binary_port_buffer == 0)
+        binary_port_buffer = malloc (length);
+      else
+        binary_port_buffer = realloc (binary_port_buffer, length);
+    }
+  long n = 0;
+  if (length > 0 && __ungetc_p (__stdin) != 0)
+    {
+      binary_port_buffer[0] = fdgetc (__stdin);
+      n = 1;
+    }
+  int r;
+  while (n < length)
+    {
+#if SYSTEM_LIBC
+      r = __buffered_read (__stdin, binary_port_buffer + n, length - n);
+#else
+      r = read (__stdin, binary_port_buffer + n, length - n);
+#endif
+      if (r <= 0)
+        return 0;
+      n = n + r;
+    }
+  return binary_port_buffer;
+}
+
+struct scm *
+write_binary (struct scm *x)            /*:((arity . n)) */
+{
+  struct scm *datum = car (x);
+  struct scm *p = cdr (x);
+  int fd = __stdout;
+  if (cell_type (p) == TPAIR)
+    {
+      struct scm *f = p->car;
+      if (cell_type (f) == TNUMBER)
+        {
+          long v = f->value;
+          if (v != 1)
+            fd = v;
+          if (v == 2)
+            fd = __stderr;
+        }
+      else if (cell_type (f) == TPORT)
+        fd = port_argument (f);
+    }
+  binary_write_init ();
+  if (binary_write_ (datum) != 0)
+    error (cell_symbol_wrong_type_arg, cons (make_string0 ("write-binary"), datum));
+  long size = binary_size;
+  binary_put_number (size);
+  if (binary_port_write (binary_buffer + size, binary_size - size, fd) != 0)
+    error (cell_symbol_system_error, make_string0 ("write-binary: write failed"));
+  if (binary_port_write (binary_buffer, size, fd) != 0)
+    error (cell_symbol_system_error, make_string0 ("write-binary: write failed"));
+  return cell_unspecified;
+}
+
+struct scm *
+read_binary (struct scm *port)          /*:((arity . n)) */
+{
+  struct scm *prev = cell_f;
+  if (cell_type (port) == TPAIR)
+    prev = set_current_input_port (port->car);
+  char const *s = binary_port_read (1);
+  if (s == 0)
+    {
+      if (prev != cell_f)
+        set_current_input_port (prev);
+      return make_char (-1);
+    }
+  long size = 0;
+  long scale = 1;
+  int c = (0x100 + s[0]) % 0x100;
+  while (c >= 128 && s != 0)
+    {
+      size = size + ((c - 128) * scale);
+      scale = scale * 128;
+      s = binary_port_read (1);
+      if (s != 0)
+        c = (0x100 + s[0]) % 0x100;
+    }
+  size = size + (c * scale);
+  if (s != 0)
+    s = binary_port_read (size);
+  if (prev != cell_f)
+    set_current_input_port (prev);
+  if (s == 0)
+    error (cell_symbol_system_error, make_string0 ("read-binary: unexpected end of file"));
+  binary_read_init (s, size);
+  struct scm *x = binary_read_ ();
+  if (binary_error != 0 || binary_input_pos != size)
+    error (cell_symbol_system_error, make_string0 ("read-binary: malformed input"));
+  return x;
+}
@@ -57,44 +57,56 @@ builtin_arity (struct scm *builtin)
   return struct_ref_ (builtin, 4);
 }
 
+/* The fields of a builtin are read straight from its struct cells:
+   these are used on every call and must not allocate.  */
+long
+builtin_arity_ (struct scm *builtin)
+{
+  struct scm *x = cell_ref (builtin->structure, 4);
+  return x->value;
+}
+
 FUNCTION
 builtin_function (struct scm *builtin)
 {
-  struct scm *x = struct_ref_ (builtin, 5);
+  struct scm *x = cell_ref (builtin->structure, 5);
   return x->function;
 }
 
 struct scm *
 builtin_p (struct scm *x)
 {
-  if (x->type == TSTRUCT)
-    if (struct_ref_ (x, 2) == cell_symbol_builtin)
-      return cell_t;
+  if (cell_type (x) == TSTRUCT && x->length > 2)
+    {
+      struct scm *e = cell_ref (x->structure, 2);
+      if (cell_type (e) == TREF && e->ref == cell_symbol_builtin)
+        return cell_t;
+    }
   return cell_f;
 }
 
 struct scm *
 builtin_printer (struct scm *builtin)
 {
-  fdputs ("#<procedure ", __stdout);
+  port_puts ("#<procedure ", __stdout);
   display_ (builtin_name (builtin));
-  fdputc (' ', __stdout);
+  port_putc (' ', __stdout);
   struct scm *x = builtin_arity (builtin);
   int arity = x->value;
   if (arity == -1)
-    fdputc ('_', __stdout);
+    port_putc ('_', __stdout);
   else
     {
-      fdputc ('(', __stdout);
+      port_putc ('(', __stdout);
       int i;
       for (i = 0; i < arity; i = i + 1)
         {
           if (i != 0)
-            fdputc (' ', __stdout);
-          fdputc ('_', __stdout);
+            port_putc (' ', __stdout);
+          port_putc ('_', __stdout);
         }
     }
-  fdputc ('>', __stdout);
+  port_putc ('>', __stdout);
 }
 
 struct scm *
@@ -131,6 +143,9 @@ mes_builtins (struct scm *a)            /*:((internal)) */
       return a;
     }
 
+  /* src/binary.c */
+  a = init_builtin (builtin_type, "write-binary", -1, &write_binary, a);
+  a = init_builtin (builtin_type, "read-binary", -1, &read_binary, a);
   /* src/builtins.c */
   a = init_builtin (builtin_type, "make-builtin", 4, &make_builtin, a);
   a = init_builtin (builtin_type, "builtin-name", 1, &builtin_name, a);
@@ -171,6 +186,7 @@ mes_builtins (struct scm *a)            /*:((internal)) */
   a = init_builtin (builtin_type, "cons", 2, &cons, a);
   a = init_builtin (builtin_type, "gc-check", 0, &gc_check, a);
   a = init_builtin (builtin_type, "gc", 0, &gc, a);
+  a = init_builtin (builtin_type, "dump-image", 1, &dump_image, a);
   /* src/hash.c */
   a = init_builtin (builtin_type, "hashq", 2, &hashq, a);
   a = init_builtin (builtin_type, "hash", 2, &hash, a);
@@ -179,6 +195,7 @@ mes_builtins (struct scm *a)            /*:((internal)) */
   a = init_builtin (builtin_type, "hash-ref", 3, &hash_ref, a);
   a = init_builtin (builtin_type, "hashq-set!", 3, &hashq_set_x, a);
   a = init_builtin (builtin_type, "hash-set!", 3, &hash_set_x, a);
+  a = init_builtin (builtin_type, "hash-count", 1, &hash_count, a);
   a = init_builtin (builtin_type, "hash-table-printer", 1, &hash_table_printer, a);
   a = init_builtin (builtin_type, "make-hash-table", 1, &make_hash_table, a);
   /* src/lib.c */
@@ -229,6 +246,9 @@ mes_builtins (struct scm *a)            /*:((internal)) */
   a = init_builtin (builtin_type, "current-input-port", 0, &current_input_port, a);
   a = init_builtin (builtin_type, "open-input-file", 1, &open_input_file, a);
   a = init_builtin (builtin_type, "open-input-string", 1, &open_input_string, a);
+  a = init_builtin (builtin_type, "open-output-string", 0, &open_output_string, a);
+  a = init_builtin (builtin_type, "get-output-string", 1, &get_output_string, a);
+  a = init_builtin (builtin_type, "close-port", 1, &close_port, a);
   a = init_builtin (builtin_type, "set-current-input-port", 1, &set_current_input_port, a);
   a = init_builtin (builtin_type, "current-output-port", 0, &current_output_port, a);
   a = init_builtin (builtin_type, "current-error-port", 0, &current_error_port, a);
@@ -0,0 +1,459 @@
+/* -*-comment-start: "//";comment-end:""-*-
+ * GNU Mes --- Maxwell Equations of Software
+ * Copyright © 2026 agent <agent@local>
+ *
+ * This file is part of GNU Mes.
+ *
+ * GNU Mes is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * GNU Mes is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Mes.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mes/lib.h"
+#include "mes/mes.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The module cache keeps the expanded forms of files loaded with
+   primitive-load in MES_CACHE, in binary s-expressions.
+
+   While a file is recorded, each of its forms is wrapped as
+   (*cache-source* . FORM) and the forms are followed by an end marker,
+   (*cache-end* . STATE), in the list that begin_expand walks.  STATE is
+   (CACHE-FILE-NAME KEY ENTRIES SOURCE ITEMS START), and it belongs to
+   the forms up to the marker; the forms of a nested load get their own
+   marker, and a load from a port or from the cache gets a marker with
+   STATE #f.
+
+   A form from the file may expand into several toplevel items, which
+   are recorded right after their expansion, before evaluation.  When
+   the next form or the marker is reached, the items become ENTRIES as
+   (*cache-form* . ITEM), which begin_expand evaluates without macro
+   expansion.  If any item holds an object that cannot be written, such
+   as a procedure inserted by a macro, the SOURCE form is kept instead,
+   to be expanded again.  A nested (primitive-load FILE) is kept as is,
+   so that FILE is looked up in the cache on its own.
+
+   Every file that is loaded by name is entered in the load log, and
+   cache_digest sums up the log.  The digest is part of the key, so a
+   file is only taken from the cache after the same files were loaded
+   before it.  The files that are loaded while a file is recorded, from
+   START in the log to its end marker, are its dependencies, which are
+   written with its forms and checked before they are used.  */
+
+// CONSTANT CACHE_VERSION 3
+#define CACHE_VERSION 3
+
+char **cache_log_name;
+long *cache_log_size;
+long *cache_log_hash;
+long cache_log_count;
+long cache_log_max;
+long cache_digest;
+
+void
+cache_init ()
+{
+  char *p = getenv ("MES_CACHE");
+  if (p != 0)
+    if (p[0] != 0)
+      cache_directory = p;
+}
+
+/* Read all of FILE_NAME into a buffer to free and store its size in
+   SIZE; return 0 if FILE_NAME cannot be read.  */
+char *
+cache_slurp (char const *file_name, long *size)
+{
+  int fd = mes_open (file_name, O_RDONLY, 0);
+  if (fd < 0)
+    return 0;
+  long max = 4096;
+  char *buffer = malloc (max);
+  long n = 0;
+  int r = 1;
+  while (r > 0)
+    {
+      if (n == max)
+        {
+          max = max * 2;
+          buffer = realloc (buffer, max);
+        }
+      r = read (fd, buffer + n, max - n);
+      if (r > 0)
+        n = n + r;
+    }
+  close (fd);
+  size[0] = n;
+  return buffer;
+}
+
+/* A hash of the LENGTH bytes at S that fits a number on any platform.  */
+long
+cache_hash (char const *s, long length)
+{
+  unsigned hash = hash_bytes (s, length);
+  hash = hash / 2;
+  return hash;
+}
+
+/* Enter FILE_NAME, with SIZE and HASH, in the load log.  */
+void
+cache_log (char const *file_name, long size, long hash)        /*:((internal)) */
+{
+  if (cache_log_count == cache_log_max)
+    {
+      cache_log_max = cache_log_max * 2 + 16;
+      cache_log_name = realloc (cache_log_name, cache_log_max * sizeof (char *));
+      cache_log_size = realloc (cache_log_size, cache_log_max * sizeof (long));
+      cache_log_hash = realloc (cache_log_hash, cache_log_max * sizeof (long));
+    }
+  char *name = malloc (strlen (file_name) + 1);
+  strcpy (name, file_name);
+  cache_log_name[cache_log_count] = name;
+  cache_log_size[cache_log_count] = size;
+  cache_log_hash[cache_log_count] = hash;
+  cache_log_count = cache_log_count + 1;
+  struct scm *x = cons (make_number (hash), cell_nil);
+  x = cons (make_number (size), x);
+  x = cons (make_number (cache_digest), x);
+  binary_write_init ();
+  binary_write_ (x);
+  cache_digest = cache_hash (binary_buffer, binary_size);
+}
+
+/* The key of FILE_NAME, of SIZE bytes that hash to HASH: the digest
+   of the files loaded before it, the directories that include-from-path
+   searches, and its contents.  Macros that are not defined by a loaded
+   file, but on the command line, in the boot file or by eval, are not
+   part of the key, and neither is which file include-from-path finds
+   first.  */
+struct scm *
+cache_key (struct scm *file_name, long size, long hash) /*:((internal)) */
+{
+  char const *path = getenv ("GUILE_LOAD_PATH");
+  if (path == 0)
+    path = "";
+  struct scm *key = cons (make_number (cache_digest), cell_nil);
+  key = cons (make_number (hash), key);
+  key = cons (make_number (size), key);
+  key = cons (module_ref (M0, cstring_to_symbol ("%moduledir")), key);
+  key = cons (make_string0 (path), key);
+  key = cons (file_name, key);
+  key = cons (module_ref (M0, cell_symbol_mes_version), key);
+  key = cons (make_number (CACHE_VERSION), key);
+  binary_write_init ();
+  binary_write_ (key);
+  return binary_make_string (binary_buffer, binary_size);
+}
+
+/* The dependencies of a file whose recording started at START in the
+   load log: a list of (FILE-NAME SIZE . HASH).  */
+struct scm *
+cache_dependencies (long start)        /*:((internal)) */
+{
+  struct scm *r = cell_nil;
+  long i;
+  for (i = cache_log_count - 1; i >= start; i = i - 1)
+    r = cons (cons (make_string0 (cache_log_name[i]),
+                    cons (make_number (cache_log_size[i]), make_number (cache_log_hash[i]))), r);
+  return r;
+}
+
+/* Return whether the files in DEPENDENCIES are unchanged.  */
+int
+cache_dependencies_p (struct scm *dependencies) /*:((internal)) */
+{
+  struct scm *x;
+  long size;
+  char *buffer;
+  long hash;
+  while (cell_type (dependencies) == TPAIR)
+    {
+      x = dependencies->car;
+      if (cell_type (x) != TPAIR || cell_type (x->car) != TSTRING || cell_type (x->cdr) != TPAIR)
+        return 0;
+      buffer = cache_slurp (cell_bytes (x->car->string), &size);
+      if (buffer == 0)
+        return 0;
+      hash = cache_hash (buffer, size);
+      free (buffer);
+      if (size != x->cdr->car->value || hash != x->cdr->cdr->value)
+        return 0;
+      dependencies = dependencies->cdr;
+    }
+  return 1;
+}
+
+struct scm *
+cache_file_name (struct scm *key)       /*:((internal)) */
+{
+  char const *s = cell_bytes (key->string);
+  long hash = cache_hash (s, key->length);
+  struct scm *name = make_string0 (cache_directory);
+  name = cons (make_string0 ("/"), cons (name, cell_nil));
+  name = cons (make_string0 (ntoab (hash, 16, 0)), name);
+  name = cons (make_string0 (".mesc"), name);
+  return string_append (reverse_x_ (name, cell_nil));
+}
+
+/* Return the dependencies and forms in BUFFER, the SIZE bytes of a
+   cache file, or 0 if they do not belong to KEY or are damaged.  */
+struct scm *
+cache_read (char const *buffer, long size, struct scm *key)     /*:((internal)) */
+{
+  if (size < key->length)
+    return 0;
+  if (memcmp (buffer, cell_bytes (key->string), key->length) != 0)
+    return 0;
+  char const *s = buffer + key->length;
+  size = size - key->length;
+  binary_read_init (s, size);
+  struct scm *forms = binary_read_ ();
+  long end = binary_input_pos;
+  long sum = binary_get_number ();
+  if (binary_error != 0 || binary_input_pos != size)
+    return 0;
+  if (sum != cache_hash (s, end))
+    return 0;
+  if (cell_type (forms) != TPAIR)
+    return 0;
+  return forms;
+}
+
+/* Return the forms of FILE_NAME from the cache followed by an end
+   marker or, when they are not in the cache, the end marker to append
+   to the forms that are read from FILE_NAME.  */
+struct scm *
+cache_load (struct scm *file_name)
+{
+  struct scm *marker = cons (cell_cache_end, cell_f);
+  long size;
+  char *buffer = cache_slurp (cell_bytes (file_name->string), &size);
+  if (buffer == 0)
+    return marker;
+  long hash = cache_hash (buffer, size);
+  free (buffer);
+  struct scm *key = cache_key (file_name, size, hash);
+  cache_log (cell_bytes (file_name->string), size, hash);
+  if (macro_get_handle (cell_symbol_portable_macro_expand) != cell_f)
+    return marker;
+  struct scm *name = cache_file_name (key);
+  struct scm *state = cons (cell_nil, cons (make_number (cache_log_count), cell_nil));
+  state = cons (cell_nil, cons (cell_unspecified, state));
+  state = cons (name, cons (key, state));
+  marker->cdr = state;
+
+  buffer = cache_slurp (cell_bytes (name->string), &size);
+  if (buffer == 0)
+    return marker;
+  struct scm *forms = cache_read (buffer, size, key);
+  free (buffer);
+  if (forms == 0)
+    return marker;
+  if (cache_dependencies_p (forms->car) == 0)
+    return marker;
+  forms = forms->cdr;
+  if (g_debug > 1)
+    {
+      eputs (";;; cached ");
+      eputs (cell_bytes (file_name->string));
+      eputs ("\n");
+    }
+  marker->cdr = cell_f;
+  return append2 (forms, cons (marker, cell_nil));
+}
+
+/* Return a copy of the pairs of X, or 0 when X holds an object that
+   cannot be written.  */
+struct scm *
+cache_copy (struct scm *x)      /*:((internal)) */
+{
+  long t = cell_type (x);
+  long i;
+  if (t == TSYMBOL || t == TSPECIAL || t == TKEYWORD || t == TSTRING
+      || t == TNUMBER || t == TCHAR)
+    return x;
+  if (t == TVECTOR)
+    {
+      for (i = 0; i < x->length; i = i + 1)
+        if (cache_copy (vector_ref_ (x, i)) == 0)
+          return 0;
+      return x;
+    }
+  if (t != TPAIR)
+    return 0;
+  struct scm *r = cell_nil;
+  struct scm *p = x;
+  struct scm *y;
+  i = 0;
+  while (cell_type (x) == TPAIR)
+    {
+      y = cache_copy (x->car);
+      if (y == 0)
+        return 0;
+      r = cons (y, r);
+      x = x->cdr;
+      i = i + 1;
+      if (i % 2 == 0)
+        {
+          p = p->cdr;
+          if (p == x)
+            return 0;
+        }
+    }
+  y = cache_copy (x);
+  if (y == 0)
+    return 0;
+  return reverse_x_ (r, y);
+}
+
+/* Return the state of the end marker that follows the first form of X,
+   a list that begin_expand walks, or #f.  */
+struct scm *
+cache_state (struct scm *x)     /*:((internal)) */
+{
+  struct scm *marker;
+  while (cell_type (x) == TPAIR)
+    {
+      marker = x->car;
+      if (cell_type (marker) == TPAIR)
+        if (marker->car == cell_cache_end)
+          {
+            if (marker->cdr != cell_f)
+              if (macro_get_handle (cell_symbol_portable_macro_expand) != cell_f)
+                {
+                  marker->cdr = cell_f;
+                  gc_write_barrier (marker);
+                }
+            return marker->cdr;
+          }
+      x = x->cdr;
+    }
+  return cell_f;
+}
+
+/* Move the items of the current form of STATE to its entries, or the
+   form itself if an item could not be recorded.  */
+void
+cache_flush (struct scm *state)         /*:((internal)) */
+{
+  struct scm *entries = state->cdr->cdr;
+  struct scm *source = entries->cdr;
+  struct scm *items = source->cdr;
+  if (source->car == cell_unspecified)
+    return;
+  struct scm *x = entries->car;
+  if (items->car == cell_f)
+    x = cons (source->car, x);
+  else
+    x = append2 (items->car, x);
+  entries->car = x;
+  gc_write_barrier (entries);
+  source->car = cell_unspecified;
+  items->car = cell_nil;
+  gc_write_barrier (source);
+  gc_write_barrier (items);
+}
+
+/* Start recording the form in the (*cache-source* . FORM) that X
+   starts with, and unwrap it.  */
+void
+cache_source (struct scm *x)
+{
+  struct scm *form = x->car->cdr;
+  x->car = form;
+  gc_write_barrier (x);
+  struct scm *state = cache_state (x);
+  if (state == cell_f)
+    return;
+  cache_flush (state);
+  struct scm *source = state->cdr->cdr->cdr;
+  struct scm *copy = cache_copy (form);
+  if (copy == 0)
+    copy = form;
+  source->car = copy;
+  gc_write_barrier (source);
+}
+
+/* Record the first item of X, a list that begin_expand is about to
+   evaluate.  */
+void
+cache_record (struct scm *x)
+{
+  struct scm *state = cache_state (x);
+  if (state == cell_f)
+    return;
+  struct scm *items = state->cdr->cdr->cdr->cdr;
+  if (items->car == cell_f)
+    return;
+  struct scm *item = cache_copy (x->car);
+  if (item == 0)
+    items->car = cell_f;
+  else
+    {
+      if (cell_type (item) != TPAIR || item->car != cell_symbol_primitive_load)
+        item = cons (cell_cache_form, item);
+      items->car = cons (item, items->car);
+    }
+  gc_write_barrier (items);
+}
+
+/* Wrap the FORMS of a file to record.  */
+struct scm *
+cache_sources (struct scm *forms)
+{
+  struct scm *r = cell_nil;
+  while (forms != cell_nil)
+    {
+      r = cons (cons (cell_cache_source, forms->car), r);
+      forms = forms->cdr;
+    }
+  return reverse_x_ (r, cell_nil);
+}
+
+/* Write the forms recorded in STATE, the state of an end marker.  */
+void
+cache_end (struct scm *state)
+{
+  if (state == cell_f)
+    return;
+  cache_flush (state);
+  struct scm *name = state->car;
+  struct scm *key = state->cdr->car;
+  struct scm *entries = state->cdr->cdr;
+  struct scm *start = entries->cdr->cdr->cdr->car;
+  struct scm *forms = reverse_x_ (entries->car, cell_nil);
+  entries->car = cell_nil;
+  forms = cons (cache_dependencies (start->value), forms);
+  binary_write_init ();
+  if (binary_write_ (forms) != 0)
+    {
+      if (g_debug > 1)
+        {
+          eputs (";;; not cached: ");
+          eputs (cell_bytes (name->string));
+          eputs ("\n");
+        }
+      return;
+    }
+  binary_put_number (cache_hash (binary_buffer, binary_size));
+  int fd = mes_open (cell_bytes (name->string), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+  if (fd < 0)
+    return;
+  if (binary_port_write (cell_bytes (key->string), key->length, fd) == 0)
+    binary_port_write (binary_buffer, binary_size, fd);
+  close (fd);
+}
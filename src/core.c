@@ -36,7 +36,7 @@ assoc_string (struct scm *x, struct scm *a)     /*:((internal)) */
   while (a != cell_nil)
     {
       b = a->car;
-      if (b->car->type == TSTRING)
+      if (cell_type (b->car) == TSTRING)
         if (string_equal_p (x, b->car) == cell_t)
           return b;
       a = a->cdr;
@@ -50,7 +50,7 @@ struct scm *
 car (struct scm *x)
 {
 #if !__MESC_MES__
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cell_symbol_car));
 #endif
   return x->car;
@@ -60,7 +60,7 @@ struct scm *
 cdr (struct scm *x)
 {
 #if !__MESC_MES__
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cell_symbol_cdr));
 #endif
   return x->cdr;
@@ -85,16 +85,16 @@ eq_p (struct scm *x, struct scm *y)
 {
   if (x == y)
     return cell_t;
-  int t = x->type;
+  int t = cell_type (x);
   if (t == TKEYWORD)
     {
-      if (y->type == TKEYWORD)
+      if (cell_type (y) == TKEYWORD)
         return string_equal_p (x, y);
       return cell_f;
     }
   if (t == TCHAR)
     {
-      if (y->type != TCHAR)
+      if (cell_type (y) != TCHAR)
         return cell_f;
       if (x->value == y->value)
         return cell_t;
@@ -102,7 +102,7 @@ eq_p (struct scm *x, struct scm *y)
     }
   if (t == TNUMBER)
     {
-      if (y->type != TNUMBER)
+      if (cell_type (y) != TNUMBER)
         return cell_f;
       if (x->value == y->value)
         return cell_t;
@@ -115,7 +115,7 @@ struct scm *
 values (struct scm *x)                  /*:((arity . n)) */
 {
   struct scm *v = cons (0, x);
-  v->type = TVALUES;
+  set_cell_type (v, TVALUES);
   return v;
 }
 
@@ -132,7 +132,7 @@ length__ (struct scm *x)                /*:((internal)) */
   while (x != cell_nil)
     {
       n = n + 1;
-      if (x->type != TPAIR)
+      if (cell_type (x) != TPAIR)
         return -1;
       x = x->cdr;
     }
@@ -166,7 +166,7 @@ append2 (struct scm *x, struct scm *y)
 {
   if (x == cell_nil)
     return y;
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cstring_to_symbol ("append2")));
   struct scm *r = cell_nil;
   while (x != cell_nil)
@@ -182,7 +182,7 @@ append_reverse (struct scm *x, struct scm *y)
 {
   if (x == cell_nil)
     return y;
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cstring_to_symbol ("append-reverse")));
   while (x != cell_nil)
     {
@@ -195,13 +195,14 @@ append_reverse (struct scm *x, struct scm *y)
 struct scm *
 reverse_x_ (struct scm *x, struct scm *t)
 {
-  if (x != cell_nil && x->type != TPAIR)
+  if (x != cell_nil && cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cstring_to_symbol ("core:reverse!")));
   struct scm *r = t;
   while (x != cell_nil)
     {
       t = x->cdr;
       x->cdr = r;
+      gc_write_barrier (x);
       r = x;
       x = t;
     }
@@ -211,9 +212,9 @@ reverse_x_ (struct scm *x, struct scm *t)
 struct scm *
 assq (struct scm *x, struct scm *a)
 {
-  if (a->type != TPAIR)
+  if (cell_type (a) != TPAIR)
     return cell_f;
-  int t = x->type;
+  int t = cell_type (x);
 
   if (t == TSYMBOL || t == TSPECIAL)
     while (a != cell_nil)
@@ -255,7 +256,7 @@ assq (struct scm *x, struct scm *a)
 struct scm *
 assoc (struct scm *x, struct scm *a)
 {
-  if (x->type == TSTRING)
+  if (cell_type (x) == TSTRING)
     return assoc_string (x, a);
   while (a != cell_nil)
     {
@@ -29,31 +29,31 @@ void
 fdwrite_char (char v, int fd)
 {
   if (v == '\0')
-    fdputs ("\\nul", fd);
+    port_puts ("\\nul", fd);
   else if (v == '\a')
-    fdputs ("\\alarm", fd);
+    port_puts ("\\alarm", fd);
   else if (v == '\b')
-    fdputs ("\\backspace", fd);
+    port_puts ("\\backspace", fd);
   else if (v == '\t')
-    fdputs ("\\tab", fd);
+    port_puts ("\\tab", fd);
   else if (v == '\n')
-    fdputs ("\\newline", fd);
+    port_puts ("\\newline", fd);
   else if (v == '\v')
-    fdputs ("\\vtab", fd);
+    port_puts ("\\vtab", fd);
   else if (v == '\f')
-    fdputs ("\\page", fd);
+    port_puts ("\\page", fd);
   /* Nyacc bug
-     else if (v == '\r') fdputs ("return", fd);
+     else if (v == '\r') port_puts ("return", fd);
   */
   else if (v == 13)
-    fdputs ("\\return", fd);
+    port_puts ("\\return", fd);
   else if (v == ' ')
-    fdputs ("\\space", fd);
+    port_puts ("\\space", fd);
   else
     {
       if (v >= 32 && v <= 127)
-        fdputc ('\\', fd);
-      fdputc (v, fd);
+        port_putc ('\\', fd);
+      port_putc (v, fd);
     }
 }
 
@@ -61,33 +61,33 @@ void
 fdwrite_string_char (char v, int fd)
 {
   if (v == '\0')
-    fdputs ("\\0", fd);
+    port_puts ("\\0", fd);
   else if (v == '\a')
-    fdputs ("\\a", fd);
+    port_puts ("\\a", fd);
   else if (v == '\b')
-    fdputs ("\\b", fd);
+    port_puts ("\\b", fd);
   else if (v == '\t')
-    fdputs ("\\t", fd);
+    port_puts ("\\t", fd);
   else if (v == '\v')
-    fdputs ("\\v", fd);
+    port_puts ("\\v", fd);
   else if (v == '\n')
-    fdputs ("\\n", fd);
+    port_puts ("\\n", fd);
   else if (v == '\f')
-    fdputs ("\\f", fd);
+    port_puts ("\\f", fd);
   /* Nyacc bug
-     else if (v == '\r') fdputs ("\\r", fd);
-     else if (v == '\e') fdputs ("\\e", fd);
+     else if (v == '\r') port_puts ("\\r", fd);
+     else if (v == '\e') port_puts ("\\e", fd);
   */
   else if (v == 13)
-    fdputs ("\\r", fd);
+    port_puts ("\\r", fd);
   else if (v == 27)
-    fdputs ("\\e", fd);
+    port_puts ("\\e", fd);
   else if (v == '\\')
-    fdputs ("\\\\", fd);
+    port_puts ("\\\\", fd);
   else if (v == '"')
-    fdputs ("\\\"", fd);
+    port_puts ("\\\"", fd);
   else
-    fdputc (v, fd);
+    port_putc (v, fd);
 }
 
 void
@@ -103,109 +103,121 @@ struct scm *display_helper (struct scm *x, int cont, char *sep, int fd, int writ
 struct scm *
 display_helper (struct scm *x, int cont, char *sep, int fd, int write_p)
 {
-  fdputs (sep, fd);
+  port_puts (sep, fd);
   if (g_depth == 0)
     return cell_unspecified;
   g_depth = g_depth - 1;
 
-  int t = x->type;
+  int t = cell_type (x);
   if (t == TCHAR)
     {
       if (write_p == 0)
-        fdputc (x->value, fd);
+        port_putc (x->value, fd);
       else
         {
-          fdputs ("#", fd);
+          port_puts ("#", fd);
           fdwrite_char (x->value, fd);
         }
     }
   else if (t == TCLOSURE)
     {
-      fdputs ("#<closure ", fd);
+      port_puts ("#<closure ", fd);
       struct scm *circ = x->cdr->car;
       struct scm *name = circ->cdr->car;
       struct scm *args = x->cdr->cdr->car;
       display_helper (name->car, 0, "", fd, 0);
-      fdputc (' ', fd);
+      port_putc (' ', fd);
       display_helper (args, 0, "", fd, 0);
-      fdputs (">", fd);
+      port_puts (">", fd);
     }
   else if (t == TMACRO)
     {
-      fdputs ("#<macro ", fd);
+      port_puts ("#<macro ", fd);
       display_helper (x->cdr, cont, "", fd, 0);
-      fdputs (">", fd);
+      port_puts (">", fd);
     }
   else if (t == TVARIABLE)
     {
-      fdputs ("#<variable ", fd);
+      port_puts ("#<variable ", fd);
       display_helper (x->variable->car, cont, "", fd, 0);
-      fdputs (">", fd);
+      port_puts (">", fd);
+    }
+  else if (t == TLEXICAL)
+    {
+      port_puts ("#<lexical ", fd);
+      port_puts (itoa (x->car_value), fd);
+      port_putc (' ', fd);
+      port_puts (itoa (x->cdr_value), fd);
+      port_puts (">", fd);
     }
   else if (t == TNUMBER)
     {
-      fdputs (itoa (x->value), fd);
+      port_puts (itoa (x->value), fd);
     }
   else if (t == TPAIR)
     {
       if (cont == 0)
-        fdputs ("(", fd);
+        port_puts ("(", fd);
       if (x->car == cell_circular && x->cdr->car != cell_closure)
         {
-          fdputs ("(*circ* . ", fd);
+          port_puts ("(*circ* . ", fd);
           int i = 0;
           x = x->cdr;
           while (x != cell_nil && i < 10)
             {
               i = i + 1;
               fdisplay_ (x->car->car, fd, write_p);
-              fdputs (" ", fd);
+              port_puts (" ", fd);
               x = x->cdr;
             }
-          fdputs (" ...)", fd);
+          port_puts (" ...)", fd);
         }
       else
         {
           if (x != 0 && x != cell_nil)
             fdisplay_ (x->car, fd, write_p);
-          if (x->cdr != 0 && x->cdr->type == TPAIR)
+          if (x->cdr != 0 && cell_type (x->cdr) == TPAIR)
             display_helper (x->cdr, 1, " ", fd, write_p);
           else if (x->cdr != 0 && x->cdr != cell_nil)
             {
-              if (x->cdr->type != TPAIR)
-                fdputs (" . ", fd);
+              if (cell_type (x->cdr) != TPAIR)
+                port_puts (" . ", fd);
               fdisplay_ (x->cdr, fd, write_p);
             }
         }
       if (cont == 0)
-        fdputs (")", fd);
+        port_puts (")", fd);
     }
   else if (t == TPORT)
     {
-      fdputs ("#<port ", fd);
-      fdputs (itoa (x->port), fd);
-      fdputs (" ", fd);
-      x = x->string;
-      fdputc ('"', fd);
-      fdwrite_string (cell_bytes (x->string), x->length, fd);
-      fdputc ('"', fd);
-      fdputs (">", fd);
+      port_puts ("#<port ", fd);
+      port_puts (itoa (x->port), fd);
+      port_puts (" ", fd);
+      struct scm *string = x->cdr->car;
+      long i = x->cdr->cdr->value;
+      port_putc ('"', fd);
+      if (cell_type (string) == TBYTES)
+        fdwrite_string (cell_bytes (string), i, fd);
+      else
+        fdwrite_string (port_bytes (string) + i, string->length - i, fd);
+      port_putc ('"', fd);
+      port_puts (">", fd);
     }
   else if (t == TKEYWORD)
     {
-      fdputs ("#:", fd);
+      port_puts ("#:", fd);
       fdwrite_string (cell_bytes (x->string), x->length, fd);
     }
   else if (t == TSTRING)
     {
       if (write_p == 1)
         {
-          fdputc ('"', fd);
+          port_putc ('"', fd);
           fdwrite_string (cell_bytes (x->string), x->length, fd);
-          fdputc ('"', fd);
+          port_putc ('"', fd);
         }
       else
-        fdputs (cell_bytes (x->string), fd);
+        port_puts (cell_bytes (x->string), fd);
     }
   else if (t == TSPECIAL || t == TSYMBOL)
     fdwrite_string (cell_bytes (x->string), x->length, fd);
@@ -214,45 +226,45 @@ display_helper (struct scm *x, int cont, char *sep, int fd, int write_p)
   else if (t == TSTRUCT)
     {
       struct scm *printer = struct_ref_ (x, STRUCT_PRINTER);
-      if (printer->type == TREF)
+      if (cell_type (printer) == TREF)
         printer = printer->ref;
-      if (printer->type == TCLOSURE || builtin_p (printer) == cell_t)
+      if (cell_type (printer) == TCLOSURE || builtin_p (printer) == cell_t)
         apply (printer, cons (x, cell_nil), R0);
       else
         {
-          fdputs ("#<", fd);
+          port_puts ("#<", fd);
           fdisplay_ (x->structure, fd, write_p);
           struct scm *t = x->car;
           long size = x->length;
           long i;
           for (i = 2; i < size; i = i + 1)
             {
-              fdputc (' ', fd);
+              port_putc (' ', fd);
               fdisplay_ (cell_ref (x->structure, i), fd, write_p);
             }
-          fdputc ('>', fd);
+          port_putc ('>', fd);
         }
     }
   else if (t == TVECTOR)
     {
-      fdputs ("#(", fd);
+      port_puts ("#(", fd);
       struct scm *t = x->car;
       long i;
       for (i = 0; i < x->length; i = i + 1)
         {
           if (i != 0)
-            fdputc (' ', fd);
+            port_putc (' ', fd);
           fdisplay_ (cell_ref (x->vector, i), fd, write_p);
         }
-      fdputc (')', fd);
+      port_putc (')', fd);
     }
   else
     {
-      fdputs ("<", fd);
-      fdputs (itoa (t), fd);
-      fdputs (":", fd);
-      fdputs (ltoa (cast_voidp_to_long (x)), fd);
-      fdputs (">", fd);
+      port_puts ("<", fd);
+      port_puts (itoa (t), fd);
+      port_puts (":", fd);
+      port_puts (ltoa (cast_voidp_to_long (x)), fd);
+      port_puts (">", fd);
     }
   return cell_unspecified;
 }
@@ -274,7 +286,9 @@ display_error_ (struct scm *x)
 struct scm *
 display_port_ (struct scm *x, struct scm *p)
 {
-  assert_msg (p->type == TNUMBER, "p->type == TNUMBER");
+  if (cell_type (p) == TPORT)
+    return fdisplay_ (x, port_argument (p), 0);
+  assert_msg (cell_type (p) == TNUMBER, "cell_type (p) == TNUMBER");
   return fdisplay_ (x, p->value, 0);
 }
 
@@ -295,7 +309,9 @@ write_error_ (struct scm *x)
 struct scm *
 write_port_ (struct scm *x, struct scm *p)
 {
-  assert_msg (p->type == TNUMBER, "p->type == TNUMBER");
+  if (cell_type (p) == TPORT)
+    return fdisplay_ (x, port_argument (p), 1);
+  assert_msg (cell_type (p) == TNUMBER, "cell_type (p) == TNUMBER");
   return fdisplay_ (x, p->value, 1);
 }
 
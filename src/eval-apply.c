@@ -23,6 +23,50 @@
 
 #include <string.h>
 
+/* The VM continuations are consecutive symbols starting at cell_vm_apply,
+   see init_symbols_; their offset is their opcode.  */
+#define VM_APPLY 0
+#define VM_APPLY2 1
+#define VM_BEGIN 2
+#define VM_BEGIN_EVAL 3
+#define VM_BEGIN_EXPAND 4
+#define VM_BEGIN_EXPAND_EVAL 5
+#define VM_BEGIN_EXPAND_MACRO 6
+#define VM_BEGIN_EXPAND_PRIMITIVE_LOAD 7
+#define VM_BEGIN_PRIMITIVE_LOAD 8
+#define VM_BEGIN_READ_INPUT_FILE 9
+#define VM_CALL_WITH_CURRENT_CONTINUATION2 10
+#define VM_CALL_WITH_ESCAPE_CONTINUATION2 11
+#define VM_CALL_WITH_VALUES2 12
+#define VM_EVAL 13
+#define VM_EVAL2 14
+#define VM_EVAL_AND 15
+#define VM_EVAL_CASE 16
+#define VM_EVAL_CHECK_FUNC 17
+#define VM_EVAL_COND 18
+#define VM_EVAL_DEFINE 19
+#define VM_EVAL_MACRO_EXPAND_EVAL 20
+#define VM_EVAL_MACRO_EXPAND_EXPAND 21
+#define VM_EVAL_OR 22
+#define VM_EVAL_PMATCH_CAR 23
+#define VM_EVAL_PMATCH_CDR 24
+#define VM_EVAL_SET_X 25
+#define VM_EVLIS 26
+#define VM_EVLIS2 27
+#define VM_EVLIS3 28
+#define VM_IF 29
+#define VM_IF_EXPR 30
+#define VM_MACRO_EXPAND 31
+#define VM_MACRO_EXPAND_CAR 32
+#define VM_MACRO_EXPAND_CASE 33
+#define VM_MACRO_EXPAND_CASE_CLAUSE 34
+#define VM_MACRO_EXPAND_CDR 35
+#define VM_MACRO_EXPAND_DEFINE 36
+#define VM_MACRO_EXPAND_DEFINE_MACRO 37
+#define VM_MACRO_EXPAND_LAMBDA 38
+#define VM_MACRO_EXPAND_SET_X 39
+#define VM_RETURN 40
+
 struct scm *
 assert_defined (struct scm *x, struct scm *e)   /*:((internal)) */
 {
@@ -35,11 +79,27 @@ struct scm *
 check_formals (struct scm *f, struct scm *formals, struct scm *args)    /*:((internal)) */
 {
   long flen;
-  if (formals->type == TNUMBER)
-    flen = formals->value;
+  long alen;
+  struct scm *x;
+  if (cell_type (formals) == TNUMBER)
+    {
+      /* Fast path: count at most FLEN + 1 arguments.  */
+      flen = formals->value;
+      if (flen == -1)
+        return cell_unspecified;
+      alen = 0;
+      x = args;
+      while (cell_type (x) == TPAIR && alen <= flen)
+        {
+          alen = alen + 1;
+          x = x->cdr;
+        }
+      if (alen == flen && x == cell_nil)
+        return cell_unspecified;
+    }
   else
     flen = length__ (formals);
-  long alen = length__ (args);
+  alen = length__ (args);
   if (alen != flen && alen != -1 && flen != -1)
     {
       char *s = "apply: wrong number of arguments; expected: ";
@@ -67,15 +127,15 @@ check_apply (struct scm *f, struct scm *e)      /*:((internal)) */
     type = "*unspecified*";
   if (f == cell_undefined)
     type = "*undefined*";
-  if (f->type == TCHAR)
+  if (cell_type (f) == TCHAR)
     type = "char";
-  if (f->type == TNUMBER)
+  if (cell_type (f) == TNUMBER)
     type = "number";
-  if (f->type == TSTRING)
+  if (cell_type (f) == TSTRING)
     type = "string";
-  if (f->type == TSTRUCT && builtin_p (f) == cell_f)
+  if (cell_type (f) == TSTRUCT && builtin_p (f) == cell_f)
     type = "#<...>";
-  if (f->type == TBROKEN_HEART)
+  if (cell_type (f) == TBROKEN_HEART)
     type = "<3";
 
   if (type != 0)
@@ -97,26 +157,166 @@ pairlis (struct scm *x, struct scm *y, struct scm *a)
 {
   if (x == cell_nil)
     return a;
-  if (x->type != TPAIR)
-    return cons (cons (x, y), a);
-  return cons (cons (car (x), car (y)), pairlis (cdr (x), cdr (y), a));
+  struct scm *frame = cell_nil;
+  struct scm *last = cell_nil;
+  struct scm *p;
+  while (cell_type (x) == TPAIR)
+    {
+      p = cons (cons (x->car, car (y)), cell_nil);
+      if (last == cell_nil)
+        frame = p;
+      else
+        last->cdr = p;
+      last = p;
+      x = x->cdr;
+      y = cdr (y);
+    }
+  if (x != cell_nil)
+    {
+      p = cons (cons (x, y), cell_nil);
+      if (last == cell_nil)
+        frame = p;
+      else
+        last->cdr = p;
+      last = p;
+    }
+  last->cdr = a;
+  return frame;
+}
+
+/* Bind FORMALS to ARGS in front of A, checking the number of arguments
+   of F in the same pass.  */
+struct scm *
+bind_formals (struct scm *f, struct scm *formals, struct scm *args, struct scm *a)      /*:((internal)) */
+{
+  struct scm *frame = a;
+  struct scm *last = cell_nil;
+  struct scm *x = formals;
+  struct scm *y = args;
+  struct scm *p;
+  while (cell_type (x) == TPAIR && cell_type (y) == TPAIR)
+    {
+      p = cons (cons (x->car, y->car), a);
+      if (last == cell_nil)
+        frame = p;
+      else
+        last->cdr = p;
+      last = p;
+      x = x->cdr;
+      y = y->cdr;
+    }
+  if (x == cell_nil && y == cell_nil)
+    return frame;
+  if (cell_type (x) != TPAIR && x != cell_nil)
+    {
+      p = cons (cons (x, y), a);
+      if (last == cell_nil)
+        frame = p;
+      else
+        last->cdr = p;
+      return frame;
+    }
+  check_formals (f, formals, args);
+  return pairlis (formals, args, a);
+}
+
+void
+frame_set_x_ (struct scm *slot, struct scm *e)  /*:((internal)) */
+{
+  set_cell_type (slot, TREF);
+  slot->ref = e;
+  slot->cdr = 0;
+}
+
+/* Bind FORMALS to ARGS of F in a vector frame of N slots, see
+   lexical_expand.  A slot refers to its value, so that it keeps the
+   identity of a number as a binding in an alist does.  */
+struct scm *
+make_frame_ (struct scm *f, struct scm *formals, struct scm *args, long n)      /*:((internal)) */
+{
+  struct scm *frame = alloc (1);
+  struct scm *v = alloc (n);
+  set_cell_type (frame, TVECTOR);
+  frame->length = n;
+  frame->vector = v;
+  struct scm *x = formals;
+  struct scm *y = args;
+  long i = 0;
+  while (cell_type (x) == TPAIR && cell_type (y) == TPAIR)
+    {
+      frame_set_x_ (cell_ref (v, i), y->car);
+      i = i + 1;
+      x = x->cdr;
+      y = y->cdr;
+    }
+  if (x == cell_nil && y == cell_nil)
+    return frame;
+  if (cell_type (x) != TPAIR && x != cell_nil)
+    {
+      frame_set_x_ (cell_ref (v, i), y);
+      return frame;
+    }
+  check_formals (f, formals, args);
+  while (cell_type (x) == TPAIR)
+    {
+      frame_set_x_ (cell_ref (v, i), car (y));
+      i = i + 1;
+      x = x->cdr;
+      y = cdr (y);
+    }
+  if (x != cell_nil)
+    frame_set_x_ (cell_ref (v, i), y);
+  return frame;
+}
+
+int
+lexical_frame_p (struct scm *x) /*:((internal)) */
+{
+  if (cell_type (x) != TPAIR)
+    return 0;
+  if (x->car != cell_closure)
+    return 0;
+  x = x->cdr;
+  return cell_type (x) == TVECTOR;
+}
+
+/* Return the slot of the lexical reference X in the environment A.
+   Every frame on the way is a (closure . FRAME) entry of a lambda
+   whose body was rewritten by lexical_expand.  */
+struct scm *
+lexical_slot (struct scm *x, struct scm *a)     /*:((internal)) */
+{
+  long depth = x->car_value;
+  while (depth != 0)
+    {
+      a = a->cdr;
+      depth = depth - 1;
+    }
+  a = a->car->cdr;
+  return cell_ref (a->vector, x->cdr_value);
 }
 
 struct scm *
 set_car_x (struct scm *x, struct scm *e)
 {
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cstring_to_symbol ("set-car!")));
   x->car = e;
+  gc_write_barrier (x);
+  /* X may be part of a form that was expanded before.  */
+  gc_clear_expanded ();
   return cell_unspecified;
 }
 
 struct scm *
 set_cdr_x (struct scm *x, struct scm *e)
 {
-  if (x->type != TPAIR)
+  if (cell_type (x) != TPAIR)
     error (cell_symbol_not_a_pair, cons (x, cstring_to_symbol ("set-cdr!")));
   x->cdr = e;
+  gc_write_barrier (x);
+  /* X may be part of a form that was expanded before.  */
+  gc_clear_expanded ();
   return cell_unspecified;
 }
 
@@ -124,11 +324,18 @@ struct scm *
 set_env_x (struct scm *x, struct scm *e, struct scm *a)
 {
   struct scm *p;
-  if (x->type == TVARIABLE)
+  if (cell_type (x) == TLEXICAL)
+    {
+      p = lexical_slot (x, a);
+      p->ref = e;
+      gc_write_barrier (p);
+      return cell_unspecified;
+    }
+  if (cell_type (x) == TVARIABLE)
     p = x->variable;
   else
     p = assert_defined (x, module_variable (a, x));
-  if (p->type != TPAIR)
+  if (cell_type (p) != TPAIR)
     error (cell_symbol_not_a_pair, cons (p, x));
   return set_cdr_x (p, e);
 }
@@ -154,14 +361,44 @@ make_variable_ (struct scm *var)        /*:((internal)) */
   return make_cell (TVARIABLE, var, 0);
 }
 
+struct scm *
+make_lexical_ (long depth, long index)  /*:((internal)) */
+{
+  return make_value_cell (TLEXICAL, depth, index);
+}
+
 struct scm *
 macro_get_handle (struct scm *name)     /*:((internal)) */
 {
-  if (name->type == TSYMBOL)
+  if (cell_type (name) == TSYMBOL)
     return hashq_get_handle (g_macros, name, cell_nil);
   return cell_f;
 }
 
+/* Fully expanded forms are remembered by identity, so that expanding
+   them again, for instance after a toplevel macro use or in a repeated
+   eval, returns at once.  */
+long
+macro_expanded_index (struct scm *x)    /*:((internal)) */
+{
+  long i = cast_scmp_to_long (x);
+  i = i / 8;
+  return i % EXPANDED_SIZE;
+}
+
+int
+macro_expanded_p (struct scm *x)        /*:((internal)) */
+{
+  return g_expanded[macro_expanded_index (x)] == x;
+}
+
+void
+macro_expanded_x (struct scm *x)        /*:((internal)) */
+{
+  g_expanded[macro_expanded_index (x)] = x;
+  g_expanded_count = g_expanded_count + 1;
+}
+
 struct scm *
 get_macro (struct scm *name)            /*:((internal)) */
 {
@@ -177,6 +414,8 @@ get_macro (struct scm *name)            /*:((internal)) */
 struct scm *
 macro_set_x (struct scm *name, struct scm *value)       /*:((internal)) */
 {
+  /* A new macro may appear in forms that were expanded before.  */
+  gc_clear_expanded ();
   return hashq_set_x (g_macros, name, value);
 }
 
@@ -196,12 +435,12 @@ push_cc (struct scm *p1, struct scm *p2, struct scm *a, struct scm *c)  /*:((int
 struct scm *
 add_formals (struct scm *formals, struct scm *x)
 {
-  while (x->type == TPAIR)
+  while (cell_type (x) == TPAIR)
     {
       formals = cons (x->car, formals);
       x = x->cdr;
     }
-  if (x->type == TSYMBOL)
+  if (cell_type (x) == TSYMBOL)
     formals = cons (x, formals);
   return formals;
 }
@@ -209,22 +448,22 @@ add_formals (struct scm *formals, struct scm *x)
 int
 formal_p (struct scm *x, struct scm *formals)   /*:((internal)) */
 {
-  if (formals->type == TSYMBOL)
+  if (cell_type (formals) == TSYMBOL)
     {
       if (x == formals)
         return 1;
       else
         return 0;
     }
-  while (formals->type == TPAIR)
+  while (cell_type (formals) == TPAIR)
     {
       if (formals->car == x)
         break;
       formals = formals->cdr;
     }
-  if (formals->type == TSYMBOL)
+  if (cell_type (formals) == TSYMBOL)
     return formals == x;
-  return formals->type == TPAIR;
+  return cell_type (formals) == TPAIR;
 }
 
 struct scm *
@@ -233,10 +472,10 @@ expand_variable_ (struct scm *x, struct scm *formals, int top_p)        /*:((int
   struct scm *a;
   struct scm *f;
   struct scm *v;
-  while (x->type == TPAIR)
+  while (cell_type (x) == TPAIR)
     {
       a = x->car;
-      if (a->type == TPAIR)
+      if (cell_type (a) == TPAIR)
         {
           if (a->car == cell_symbol_lambda)
             {
@@ -262,14 +501,31 @@ expand_variable_ (struct scm *x, struct scm *formals, int top_p)        /*:((int
           else if (a == cell_symbol_define || a == cell_symbol_define_macro)
             {
               f = x->cdr->car;
-              if (top_p != 0 && f->type == TPAIR)
+              if (top_p != 0 && cell_type (f) == TPAIR)
                 f = f->cdr;
               formals = add_formals (formals, f);
               x = x->cdr;
             }
           else if (a == cell_symbol_quote)
             return cell_unspecified;
-          else if (a->type == TSYMBOL
+          else if (a == cell_symbol_case)
+            {
+              /* The datums of a case clause are not evaluated.  */
+              x = x->cdr;
+              a = x->car;
+              if (cell_type (a) == TPAIR && a->car != cell_symbol_quote)
+                expand_variable_ (a, formals, 0);
+              x = x->cdr;
+              while (cell_type (x) == TPAIR)
+                {
+                  a = x->car;
+                  if (cell_type (a) == TPAIR)
+                    expand_variable_ (a->cdr, formals, 0);
+                  x = x->cdr;
+                }
+              return cell_unspecified;
+            }
+          else if (cell_type (a) == TSYMBOL
                    && a != cell_symbol_boot_module
                    && a != cell_symbol_current_module
                    && a != cell_symbol_primitive_load
@@ -277,7 +533,10 @@ expand_variable_ (struct scm *x, struct scm *formals, int top_p)        /*:((int
             {
               v = module_variable (R0, a);
               if (v != cell_f)
-                x->car = make_variable_ (v);
+                {
+                  x->car = make_variable_ (v);
+                  gc_write_barrier (x);
+                }
             }
         }
       x = x->cdr;
@@ -292,24 +551,367 @@ expand_variable (struct scm *x, struct scm *formals)    /*:((internal)) */
   return expand_variable_ (x, formals, 1);
 }
 
+/* Lexical addressing.  A lambda whose body cannot capture its
+   environment binds its formals in a vector frame instead of an alist,
+   and the references to them become lexical cells that hold the depth
+   of their frame and their index in it.  Such a body starts with a
+   lexical cell of depth -1 that holds the size of the frame.  */
+
+/* Return whether X is a symbol that eval dispatches on or does not
+   look up, so that it cannot be rewritten.  */
+int
+lexical_special_p (struct scm *x)       /*:((internal)) */
+{
+  if (x == cell_symbol_quote
+      || x == cell_symbol_lambda
+      || x == cell_symbol_define
+      || x == cell_symbol_define_macro
+      || x == cell_symbol_set_x
+      || x == cell_symbol_if
+      || x == cell_symbol_begin
+      || x == cell_symbol_and
+      || x == cell_symbol_or
+      || x == cell_symbol_cond
+      || x == cell_symbol_case
+      || x == cell_symbol_pmatch_car
+      || x == cell_symbol_pmatch_cdr
+      || x == cell_symbol_current_module
+      || x == cell_symbol_boot_module
+      || x == cell_symbol_primitive_load
+      || x == cell_symbol_call_with_current_continuation
+      || x == cell_symbol_call_with_escape_continuation
+      || x == cell_symbol_call_with_values)
+    return 1;
+  return 0;
+}
+
+int
+lexical_formals_p (struct scm *formals) /*:((internal)) */
+{
+  struct scm *x;
+  while (cell_type (formals) == TPAIR)
+    {
+      x = formals->car;
+      if (cell_type (x) != TSYMBOL || lexical_special_p (x) != 0)
+        return 0;
+      formals = formals->cdr;
+    }
+  if (formals == cell_nil)
+    return 1;
+  return cell_type (formals) == TSYMBOL && lexical_special_p (formals) == 0;
+}
+
+/* Return whether evaluating X may see or extend the environment as an
+   alist: through current-module, an internal define or a primitive-load
+   whose forms are evaluated in it, or a lambda whose formals cannot be
+   rewritten.  */
+int
+lexical_capture_p (struct scm *x)       /*:((internal)) */
+{
+  struct scm *a;
+  if (cell_type (x) != TPAIR)
+    return 0;
+  if (x->car == cell_symbol_quote)
+    return 0;
+  if (x->car == cell_symbol_lambda && cell_type (x->cdr) == TPAIR)
+    if (lexical_formals_p (x->cdr->car) == 0)
+      return 1;
+  while (cell_type (x) == TPAIR)
+    {
+      a = x->car;
+      if (a == cell_symbol_define
+          || a == cell_symbol_define_macro
+          || a == cell_symbol_current_module
+          || a == cell_symbol_primitive_load)
+        return 1;
+      if (lexical_capture_p (a) != 0)
+        return 1;
+      x = x->cdr;
+    }
+  return 0;
+}
+
+long
+lexical_index (struct scm *x, struct scm *formals)      /*:((internal)) */
+{
+  long i = 0;
+  while (cell_type (formals) == TPAIR)
+    {
+      if (formals->car == x)
+        return i;
+      i = i + 1;
+      formals = formals->cdr;
+    }
+  if (formals == x)
+    return i;
+  return -1;
+}
+
+/* Return the lexical reference to X in SCOPE, a list of the formals of
+   the enclosing frames, or X itself.  */
+struct scm *
+lexical_lookup (struct scm *x, struct scm *scope)       /*:((internal)) */
+{
+  long depth = 0;
+  long i;
+  while (scope != cell_nil)
+    {
+      i = lexical_index (x, scope->car);
+      if (i != -1)
+        return make_lexical_ (depth, i);
+      depth = depth + 1;
+      scope = scope->cdr;
+    }
+  return x;
+}
+
+struct scm *lexical_expand (struct scm *x, struct scm *scope);
+
+/* Rewrite the elements of the list X, sharing it if none changes.  */
+struct scm *
+lexical_list (struct scm *x, struct scm *scope) /*:((internal)) */
+{
+  struct scm *r = cell_nil;
+  struct scm *y = x;
+  struct scm *e;
+  int changed_p = 0;
+  while (cell_type (y) == TPAIR)
+    {
+      e = lexical_expand (y->car, scope);
+      if (e != y->car)
+        changed_p = 1;
+      r = cons (e, r);
+      y = y->cdr;
+    }
+  if (changed_p == 0)
+    return x;
+  return reverse_x_ (r, y);
+}
+
+/* Rewrite BODY of a lambda with FORMALS in SCOPE, starting it with a
+   frame marker if the lambda can use a vector frame.  */
+struct scm *
+lexical_body (struct scm *formals, struct scm *body, struct scm *scope) /*:((internal)) */
+{
+  long n;
+  struct scm *x;
+  if (cell_type (body) == TPAIR)
+    {
+      x = body->car;
+      if (cell_type (x) == TLEXICAL)
+        return body;
+    }
+  if (lexical_formals_p (formals) == 0 || lexical_capture_p (body) != 0)
+    return lexical_list (body, cell_nil);
+  n = 0;
+  x = formals;
+  while (cell_type (x) == TPAIR)
+    {
+      n = n + 1;
+      x = x->cdr;
+    }
+  if (x != cell_nil)
+    n = n + 1;
+  body = lexical_list (body, cons (formals, scope));
+  return cons (make_lexical_ (-1, n), body);
+}
+
+/* Rewrite the references to the formals of the lambdas in X, a fully
+   macro-expanded form, and return the result.  Changed pairs are
+   copied, as the same form may appear in another scope.  */
+struct scm *
+lexical_expand (struct scm *x, struct scm *scope)
+{
+  struct scm *a;
+  struct scm *f;
+  struct scm *body;
+  struct scm *clauses;
+  struct scm *r;
+  if (cell_type (x) == TSYMBOL)
+    return lexical_lookup (x, scope);
+  if (cell_type (x) != TPAIR)
+    return x;
+  a = x->car;
+  if (a == cell_symbol_quote)
+    return x;
+  if (a == cell_symbol_lambda || a == cell_symbol_define || a == cell_symbol_define_macro)
+    {
+      if (cell_type (x->cdr) != TPAIR)
+        return x;
+      f = x->cdr->car;
+      if (a == cell_symbol_lambda || cell_type (f) == TPAIR)
+        {
+          if (a != cell_symbol_lambda)
+            f = f->cdr;
+          body = lexical_body (f, x->cdr->cdr, scope);
+          if (body == x->cdr->cdr)
+            return x;
+          return cons (a, cons (x->cdr->car, body));
+        }
+      body = lexical_list (x->cdr->cdr, scope);
+      if (body == x->cdr->cdr)
+        return x;
+      return cons (a, cons (f, body));
+    }
+  if (a == cell_symbol_case && cell_type (x->cdr) == TPAIR)
+    {
+      /* The datums of a case clause are not evaluated.  */
+      r = cell_nil;
+      clauses = x->cdr->cdr;
+      while (cell_type (clauses) == TPAIR)
+        {
+          f = clauses->car;
+          if (cell_type (f) == TPAIR)
+            f = cons (f->car, lexical_list (f->cdr, scope));
+          r = cons (f, r);
+          clauses = clauses->cdr;
+        }
+      r = reverse_x_ (r, clauses);
+      return cons (a, cons (lexical_expand (x->cdr->car, scope), r));
+    }
+  return lexical_list (x, scope);
+}
+
+/* A leaf is an expression that evaluates without pushing a frame: a
+   constant, a quotation, a variable or a symbol.  */
+int
+eval_leaf_p (struct scm *x)     /*:((internal)) */
+{
+  if (cell_type (x) != TPAIR)
+    return 1;
+  if (x->car == cell_symbol_quote)
+    return 1;
+  return 0;
+}
+
+struct scm *
+eval_leaf (struct scm *x)       /*:((internal)) */
+{
+  int t = cell_type (x);
+  if (t == TPAIR)
+    return x->cdr->car;
+  if (t == TVARIABLE)
+    {
+      x = x->variable;
+      return x->cdr;
+    }
+  if (t == TLEXICAL)
+    {
+      x = lexical_slot (x, R0);
+      return x->ref;
+    }
+  if (t == TSYMBOL)
+    {
+      if (x == cell_symbol_boot_module
+          || x == cell_symbol_current_module
+          || x == cell_symbol_begin
+          || x == cell_symbol_call_with_current_continuation
+          || x == cell_symbol_call_with_escape_continuation)
+        return x;
+      return assert_defined (x, module_ref (R0, x));
+    }
+  if (t == TBROKEN_HEART)
+    error (cell_symbol_system_error, x);
+  return x;
+}
+
+/* Evaluate the operator of an application if it is a leaf.  Apply
+   dispatches on symbols such as call-with-values and resolves an
+   operator that names a symbol in its own frame, which call/cc
+   captures; such operators are left for apply.  */
+struct scm *
+eval_operator (struct scm *x)   /*:((internal)) */
+{
+  struct scm *v;
+  if (x == cell_symbol_call_with_values)
+    return x;
+  if (eval_leaf_p (x) == 0)
+    return x;
+  v = eval_leaf (x);
+  if (cell_type (v) == TSYMBOL)
+    return x;
+  return v;
+}
+
+int
+evlis_leaves_p (struct scm *x)  /*:((internal)) */
+{
+  while (cell_type (x) == TPAIR)
+    {
+      if (eval_leaf_p (x->car) == 0)
+        return 0;
+      x = x->cdr;
+    }
+  return x == cell_nil;
+}
+
+struct scm *
+evlis_leaves (struct scm *x)    /*:((internal)) */
+{
+  struct scm *args = cell_nil;
+  struct scm *last = cell_nil;
+  struct scm *p;
+  while (x != cell_nil)
+    {
+      p = cons (eval_leaf (x->car), cell_nil);
+      if (last == cell_nil)
+        args = p;
+      else
+        last->cdr = p;
+      last = p;
+      x = x->cdr;
+    }
+  return args;
+}
+
+/* Return the first clause of a case expression that matches KEY, or #f.
+   A single datum is compared with eq?, a list of datums with equal?.  */
+struct scm *
+case_clause (struct scm *key, struct scm *clauses)      /*:((internal)) */
+{
+  struct scm *clause;
+  struct scm *datums;
+  while (clauses != cell_nil)
+    {
+      clause = clauses->car;
+      datums = clause->car;
+      if (cell_type (datums) != TPAIR)
+        return clause;
+      if (datums->cdr == cell_nil)
+        {
+          if (eq_p (key, datums->car) == cell_t)
+            return clause;
+        }
+      else
+        while (datums != cell_nil)
+          {
+            if (equal2_p (key, datums->car) == cell_t)
+              return clause;
+            datums = datums->cdr;
+          }
+      clauses = clauses->cdr;
+    }
+  return cell_f;
+}
+
 struct scm *
 apply_builtin (struct scm *fn, struct scm *x)   /*:((internal)) */
 {
-  struct scm *a = builtin_arity (fn);
+  struct scm *a;
   struct scm *d;
-  int arity = a->value;
+  int arity = builtin_arity_ (fn);
   if ((arity > 0 || arity == -1) && x != cell_nil)
     {
       a = x->car;
-      if (a->type == TVALUES)
+      if (cell_type (a) == TVALUES)
         x = cons (a->cdr->car, x->cdr);
     }
   if ((arity > 1 || arity == -1) && x != cell_nil)
     {
       a = x->car;
       d = x->cdr;
-      if (d->type == TPAIR)
-        if (d->car->type == TVALUES)
+      if (cell_type (d) == TPAIR)
+        if (cell_type (d->car) == TVALUES)
           x = cons (a, cons (d->car->cdr->car, d));
     }
 
@@ -354,6 +956,94 @@ eval_apply ()
   long i;
 
 eval_apply:
+#if !__M2_PLANET__
+  switch (R3 - cell_vm_apply)
+    {
+    case VM_APPLY:
+      goto apply;
+    case VM_APPLY2:
+      goto apply2;
+    case VM_BEGIN:
+      goto begin;
+    case VM_BEGIN_EVAL:
+      goto begin_eval;
+    case VM_BEGIN_EXPAND:
+      goto begin_expand;
+    case VM_BEGIN_EXPAND_EVAL:
+      goto begin_expand_eval;
+    case VM_BEGIN_EXPAND_MACRO:
+      goto begin_expand_macro;
+    case VM_BEGIN_EXPAND_PRIMITIVE_LOAD:
+      goto begin_expand_primitive_load;
+    case VM_BEGIN_PRIMITIVE_LOAD:
+      goto begin_primitive_load;
+    case VM_CALL_WITH_CURRENT_CONTINUATION2:
+      goto call_with_current_continuation2;
+    case VM_CALL_WITH_ESCAPE_CONTINUATION2:
+      goto call_with_escape_continuation2;
+    case VM_CALL_WITH_VALUES2:
+      goto call_with_values2;
+    case VM_EVAL:
+      goto eval;
+    case VM_EVAL2:
+      goto eval2;
+    case VM_EVAL_AND:
+      goto eval_and;
+    case VM_EVAL_CASE:
+      goto eval_case;
+    case VM_EVAL_CHECK_FUNC:
+      goto eval_check_func;
+    case VM_EVAL_COND:
+      goto eval_cond;
+    case VM_EVAL_DEFINE:
+      goto eval_define;
+    case VM_EVAL_MACRO_EXPAND_EVAL:
+      goto eval_macro_expand_eval;
+    case VM_EVAL_MACRO_EXPAND_EXPAND:
+      goto eval_macro_expand_expand;
+    case VM_EVAL_OR:
+      goto eval_or;
+    case VM_EVAL_PMATCH_CAR:
+      goto eval_pmatch_car;
+    case VM_EVAL_PMATCH_CDR:
+      goto eval_pmatch_cdr;
+    case VM_EVAL_SET_X:
+      goto eval_set_x;
+    case VM_EVLIS:
+      goto evlis;
+    case VM_EVLIS2:
+      goto evlis2;
+    case VM_EVLIS3:
+      goto evlis3;
+    case VM_IF:
+      goto vm_if;
+    case VM_IF_EXPR:
+      goto if_expr;
+    case VM_MACRO_EXPAND:
+      goto macro_expand;
+    case VM_MACRO_EXPAND_CAR:
+      goto macro_expand_car;
+    case VM_MACRO_EXPAND_CASE:
+      goto macro_expand_case;
+    case VM_MACRO_EXPAND_CASE_CLAUSE:
+      goto macro_expand_case_clause;
+    case VM_MACRO_EXPAND_CDR:
+      goto macro_expand_cdr;
+    case VM_MACRO_EXPAND_DEFINE:
+      goto macro_expand_define;
+    case VM_MACRO_EXPAND_DEFINE_MACRO:
+      goto macro_expand_define_macro;
+    case VM_MACRO_EXPAND_LAMBDA:
+      goto macro_expand_lambda;
+    case VM_MACRO_EXPAND_SET_X:
+      goto macro_expand_set_x;
+    case VM_RETURN:
+      goto vm_return;
+    }
+  if (R3 == cell_unspecified)
+    return R1;
+  assert_msg (0, "eval/apply unknown continuation");
+#else
   if (R3 == cell_vm_evlis2)
     goto evlis2;
   else if (R3 == cell_vm_evlis3)
@@ -366,6 +1056,14 @@ eval_apply:
     goto apply2;
   else if (R3 == cell_vm_if_expr)
     goto if_expr;
+  else if (R3 == cell_vm_eval_and)
+    goto eval_and;
+  else if (R3 == cell_vm_eval_or)
+    goto eval_or;
+  else if (R3 == cell_vm_eval_cond)
+    goto eval_cond;
+  else if (R3 == cell_vm_eval_case)
+    goto eval_case;
   else if (R3 == cell_vm_begin_eval)
     goto begin_eval;
   else if (R3 == cell_vm_eval_set_x)
@@ -392,8 +1090,14 @@ eval_apply:
     goto begin_expand_eval;
   else if (R3 == cell_vm_call_with_current_continuation2)
     goto call_with_current_continuation2;
+  else if (R3 == cell_vm_call_with_escape_continuation2)
+    goto call_with_escape_continuation2;
   else if (R3 == cell_vm_macro_expand_set_x)
     goto macro_expand_set_x;
+  else if (R3 == cell_vm_macro_expand_case)
+    goto macro_expand_case;
+  else if (R3 == cell_vm_macro_expand_case_clause)
+    goto macro_expand_case_clause;
   else if (R3 == cell_vm_eval_pmatch_cdr)
     goto eval_pmatch_cdr;
   else if (R3 == cell_vm_macro_expand_define_macro)
@@ -425,12 +1129,18 @@ eval_apply:
     return R1;
   else
     assert_msg (0, "eval/apply unknown continuation");
+#endif
 
 evlis:
   if (R1 == cell_nil)
     goto vm_return;
-  if (R1->type != TPAIR)
+  if (cell_type (R1) != TPAIR)
     goto eval;
+  if (eval_leaf_p (R1->car) != 0)
+    {
+      push_cc (R1->cdr, eval_leaf (R1->car), R0, cell_vm_evlis3);
+      goto evlis;
+    }
   push_cc (R1->car, R1, R0, cell_vm_evlis2);
   goto eval;
 evlis2:
@@ -443,7 +1153,7 @@ evlis3:
 apply:
   g_stack_array[g_stack + GC_FRAME_PROCEDURE] = R1->car;
   a = R1->car;
-  t = a->type;
+  t = cell_type (a);
   if (t == TSTRUCT && builtin_p (R1->car) == cell_t)
     {
       check_formals (R1->car, builtin_arity (R1->car), R1->cdr);
@@ -457,9 +1167,33 @@ apply:
       formals = cl->cdr->car;
       args = R1->cdr;
       aa = cl->car->cdr;
-      aa = aa->cdr;
-      check_formals (R1->car, formals, R1->cdr);
-      p = pairlis (formals, args, aa);
+      /* The first entry of an alist environment is its closure entry
+         or the name of a define, but a frame entry holds bindings.  */
+      if (lexical_frame_p (aa->car) == 0)
+        aa = aa->cdr;
+      if (cell_type (body) == TPAIR)
+        if (cell_type (body->car) == TLEXICAL)
+          {
+            x = make_frame_ (R1->car, formals, args, body->car->cdr_value);
+            R0 = cons (cons (cell_closure, x), aa);
+            R1 = body;
+#if MES_HAVE_JIT
+            if (g_jit != 0)
+              {
+                x = jit_apply ();
+                if (x == cell_vm_apply)
+                  goto apply;
+                if (x != 0)
+                  {
+                    R1 = x;
+                    goto vm_return;
+                  }
+              }
+#endif
+            R1 = R1->cdr;
+            goto begin;
+          }
+      p = bind_formals (R1->car, formals, args, aa);
       call_lambda (body, p, aa, R0);
       goto begin;
     }
@@ -467,7 +1201,21 @@ apply:
     {
       a = R1->car;
       v = a->continuation;
-      if (v->length != 0)
+      /* The frame of an escape continuation that was skipped by an outer
+         escape is gone; another frame may be at its depth.  */
+      if (cell_type (v) == TNUMBER)
+        if (v->value < g_stack || g_stack_array[v->value + 1] != a)
+          {
+            a->continuation = cell_f;
+            gc_write_barrier (a);
+            v = cell_f;
+          }
+      if (cell_type (v) == TNUMBER)
+        g_stack = v->value;
+      else if (v == cell_f)
+        error (cell_symbol_system_error,
+               cons (make_string0 ("escape continuation no longer valid"), a));
+      else if (v->length != 0)
         {
           for (i = 0; i < v->length; i = i + 1)
             g_stack_array[STACK_SIZE - v->length + i] = vector_ref_ (v, i);
@@ -507,6 +1255,11 @@ apply:
           R1 = R1->cdr;
           goto call_with_current_continuation;
         }
+      if (c == cell_symbol_call_with_escape_continuation)
+        {
+          R1 = R1->cdr;
+          goto call_with_escape_continuation;
+        }
       if (c == cell_symbol_call_with_values)
         {
           R1 = R1->cdr;
@@ -530,8 +1283,15 @@ apply:
           formals = R1->car->cdr->car;
           args = R1->cdr;
           body = R1->car->cdr->cdr;
-          p = pairlis (formals, R1->cdr, R0);
-          check_formals (R1, formals, args);
+          if (cell_type (body) == TPAIR)
+            if (cell_type (body->car) == TLEXICAL)
+              {
+                x = make_frame_ (R1, formals, args, body->car->cdr_value);
+                R0 = cons (cons (cell_closure, x), R0);
+                R1 = body->cdr;
+                goto begin;
+              }
+          p = bind_formals (R1, formals, args, R0);
           call_lambda (body, p, p, R0);
           goto begin;
         }
@@ -544,7 +1304,7 @@ apply2:
   goto apply;
 
 eval:
-  t = R1->type;
+  t = cell_type (R1);
   if (t == TPAIR)
     {
       c = R1->car;
@@ -587,6 +1347,26 @@ eval:
           R1 = R1->cdr;
           goto vm_if;
         }
+      else if (c == cell_symbol_and)
+        {
+          R1 = R1->cdr;
+          goto vm_and;
+        }
+      else if (c == cell_symbol_or)
+        {
+          R1 = R1->cdr;
+          goto vm_or;
+        }
+      else if (c == cell_symbol_cond)
+        {
+          R1 = R1->cdr;
+          goto vm_cond;
+        }
+      else if (c == cell_symbol_case)
+        {
+          R1 = R1->cdr;
+          goto vm_case;
+        }
       else if (c == cell_symbol_set_x)
         {
           push_cc (R1->cdr->cdr->car, R1, R0, cell_vm_eval_set_x);
@@ -607,7 +1387,7 @@ eval:
         }
       else
         {
-          if (R1->type == TPAIR)
+          if (cell_type (R1) == TPAIR)
             if (R1->car == cell_symbol_define || R1->car == cell_symbol_define_macro)
               {
                 global_p = 0;
@@ -620,7 +1400,7 @@ eval:
                   {
                     name = R1->cdr->car;
                     aa = R1->cdr->car;
-                    if (aa->type == TPAIR)
+                    if (cell_type (aa) == TPAIR)
                       name = name->car;
                     if (macro_p != 0)
                       {
@@ -637,7 +1417,7 @@ eval:
                   }
                 R2 = R1;
                 aa = R1->cdr->car;
-                if (aa->type != TPAIR)
+                if (cell_type (aa) != TPAIR)
                   {
                     push_cc (R1->cdr->cdr->car, R2, cons (cons (R1->cdr->car, R1->cdr->car), R0), cell_vm_eval_define);
                     goto eval;
@@ -657,7 +1437,7 @@ eval:
               eval_define:
                 name = R2->cdr->car;
                 aa = R2->cdr->car;
-                if (aa->type == TPAIR)
+                if (cell_type (aa) == TPAIR)
                   name = name->car;
                 if (macro_p != 0)
                   {
@@ -682,14 +1462,30 @@ eval:
                 R1 = cell_unspecified;
                 goto vm_return;
               }
-          push_cc (R1->car, R1, R0, cell_vm_eval_check_func);
           gc_check ();
+          a = R1->car;
+          if (eval_leaf_p (a) != 0 || a->car == cell_symbol_lambda)
+            {
+              /* A leaf operator is evaluated once, after its arguments,
+                 instead of once before and once more in apply.  A
+                 lambda operator, as in an expanded let, is bound
+                 directly by apply without building a closure.  */
+              if (evlis_leaves_p (R1->cdr) != 0)
+                {
+                  x = eval_operator (R1->car);
+                  R1 = cons (x, evlis_leaves (R1->cdr));
+                  goto apply;
+                }
+              push_cc (R1->cdr, R1, R0, cell_vm_eval2);
+              goto evlis;
+            }
+          push_cc (R1->car, R1, R0, cell_vm_eval_check_func);
           goto eval;
         eval_check_func:
           push_cc (R2->cdr, R2, R0, cell_vm_eval2);
           goto evlis;
         eval2:
-          R1 = cons (R2->car, R1);
+          R1 = cons (eval_operator (R2->car), R1);
           goto apply;
         }
     }
@@ -703,6 +1499,8 @@ eval:
         goto vm_return;
       if (R1 == cell_symbol_call_with_current_continuation)
         goto vm_return;
+      if (R1 == cell_symbol_call_with_escape_continuation)
+        goto vm_return;
       R1 = assert_defined (R1, module_ref (R0, R1));
       goto vm_return;
     }
@@ -712,13 +1510,21 @@ eval:
       R1 = x->cdr;
       goto vm_return;
     }
+  else if (t == TLEXICAL)
+    {
+      x = lexical_slot (R1, R0);
+      R1 = x->ref;
+      goto vm_return;
+    }
   else if (t == TBROKEN_HEART)
     error (cell_symbol_system_error, R1);
   else
     goto vm_return;
 
 macro_expand:
-  if (R1->type != TPAIR || R1->car == cell_symbol_quote)
+  if (cell_type (R1) != TPAIR || R1->car == cell_symbol_quote)
+    goto vm_return;
+  if (macro_expanded_p (R1) != 0)
     goto vm_return;
 
   if (R1->car == cell_symbol_lambda)
@@ -727,11 +1533,12 @@ macro_expand:
       goto macro_expand;
     macro_expand_lambda:
       R2->cdr->cdr = R1;
+      gc_write_barrier (R2->cdr);
       R1 = R2;
-      goto vm_return;
+      goto macro_expand_done;
     }
 
-  if (R1->type == TPAIR)
+  if (cell_type (R1) == TPAIR)
     {
       macro = get_macro (R1->car);
       if (macro != cell_f)
@@ -748,6 +1555,7 @@ macro_expand:
       goto macro_expand;
     macro_expand_define:
       R2->cdr->cdr = R1;
+      gc_write_barrier (R2->cdr);
       R1 = R2;
       if (R1->car == cell_symbol_define_macro)
         {
@@ -756,7 +1564,7 @@ macro_expand:
         macro_expand_define_macro:
           R1 = R2;
         }
-      goto vm_return;
+      goto macro_expand_done;
     }
 
   if (R1->car == cell_symbol_set_x)
@@ -765,14 +1573,44 @@ macro_expand:
       goto macro_expand;
     macro_expand_set_x:
       R2->cdr->cdr = R1;
+      gc_write_barrier (R2->cdr);
       R1 = R2;
-      goto vm_return;
+      goto macro_expand_done;
+    }
+
+  if (R1->car == cell_symbol_case)
+    {
+      push_cc (R1->cdr->car, R1, R0, cell_vm_macro_expand_case);
+      goto macro_expand;
+    macro_expand_case:
+      R2->cdr->car = R1;
+      gc_write_barrier (R2->cdr);
+      R1 = R2;
+      /* Expand the clause bodies, but not their datums.  */
+      x = R1->cdr->cdr;
+      while (x != cell_nil)
+        {
+          a = x->car;
+          if (cell_type (a) == TPAIR)
+            {
+              push_cc (a->cdr, cons (R1, x), R0, cell_vm_macro_expand_case_clause);
+              goto macro_expand;
+            macro_expand_case_clause:
+              x = R2->cdr;
+              a = x->car;
+              a->cdr = R1;
+              gc_write_barrier (a);
+              R1 = R2->car;
+            }
+          x = x->cdr;
+        }
+      goto macro_expand_done;
     }
 
-  if (R1->type == TPAIR)
+  if (cell_type (R1) == TPAIR)
     {
       a = R1->car;
-      if (a->type == TSYMBOL && a != cell_symbol_begin)
+      if (cell_type (a) == TSYMBOL && a != cell_symbol_begin)
         {
           macro = macro_get_handle (cell_symbol_portable_macro_expand);
           if (macro != cell_f)
@@ -801,17 +1639,21 @@ macro_expand:
 
 macro_expand_car:
   R2->car = R1;
+  gc_write_barrier (R2);
   R1 = R2;
   if (R1->cdr == cell_nil)
-    goto vm_return;
+    goto macro_expand_done;
 
   push_cc (R1->cdr, R1, R0, cell_vm_macro_expand_cdr);
   goto macro_expand;
 
 macro_expand_cdr:
   R2->cdr = R1;
+  gc_write_barrier (R2);
   R1 = R2;
-
+macro_expand_done:
+  if (macro_get_handle (cell_symbol_portable_macro_expand) == cell_f)
+    macro_expanded_x (R1);
   goto vm_return;
 
 begin:
@@ -819,7 +1661,7 @@ begin:
   while (R1 != cell_nil)
     {
       gc_check ();
-      if (R1->type == TPAIR)
+      if (cell_type (R1) == TPAIR)
         {
           if (R1->car->car == cell_symbol_primitive_load)
             {
@@ -828,14 +1670,15 @@ begin:
               goto begin_expand;
             begin_primitive_load:
               R2->car = R1;
+              gc_write_barrier (R2);
               R1 = R2;
             }
         }
 
-      if (R1->type == TPAIR)
+      if (cell_type (R1) == TPAIR)
         {
           a = R1->car;
-          if (a->type == TPAIR)
+          if (cell_type (a) == TPAIR)
             {
               if (a->car == cell_symbol_begin)
                 R1 = append2 (a->cdr, R1->cdr);
@@ -863,23 +1706,65 @@ begin_expand:
     begin_expand_while:
       gc_check ();
 
-      if (R1->type == TPAIR)
+      if (cell_type (R1) == TPAIR)
         {
           a = R1->car;
-          if (a->type == TPAIR)
+          if (cell_type (a) == TPAIR)
             if (R1->car->car == cell_symbol_begin)
               R1 = append2 (R1->car->cdr, R1->cdr);
+          a = R1->car;
+          if (cell_type (a) == TPAIR)
+            {
+              if (a->car == cell_cache_end)
+                {
+                  cache_end (a->cdr);
+                  R1 = R1->cdr;
+                  if (R1 == cell_nil)
+                    {
+                      R1 = x;
+                      goto vm_return;
+                    }
+                  goto begin_expand_while;
+                }
+              if (a->car == cell_cache_form)
+                {
+                  R1->car = a->cdr;
+                  gc_write_barrier (R1);
+                  goto begin_expand_cached;
+                }
+              if (a->car == cell_cache_source)
+                {
+                  cache_source (R1);
+                  goto begin_expand_while;
+                }
+            }
           if (R1->car->car == cell_symbol_primitive_load)
             {
+              if (cache_directory != 0)
+                cache_record (R1);
               push_cc (R1->car->cdr->car, R1, R0, cell_vm_begin_expand_primitive_load);
               goto eval;
             begin_expand_primitive_load:
-              if ((R1->type == TNUMBER) && R1->value == 0)
-                0;
-              else if (R1->type == TSTRING)
-                input = set_current_input_port (open_input_file (R1));
-              else if (R1->type == TPORT)
-                input = set_current_input_port (R1);
+              input = current_input_port ();
+              program = cell_f;
+              if (cache_directory != 0)
+                {
+                  if (cell_type (R1) == TSTRING)
+                    program = cache_load (R1);
+                  else
+                    program = cons (cell_cache_end, cell_f);
+                  if (program->car != cell_cache_end)
+                    {
+                      R1 = program;
+                      goto begin_expand_primitive_load_cached;
+                    }
+                }
+              if ((cell_type (R1) == TNUMBER) && R1->value == 0)
+                input = R1;
+              else if (cell_type (R1) == TSTRING)
+                set_current_input_port (open_input_file (R1));
+              else if (cell_type (R1) == TPORT)
+                set_current_input_port (R1);
               else
                 {
                   eputs ("begin_expand failed, R1=");
@@ -891,12 +1776,20 @@ begin_expand:
               x = read_input_file_env (R0);
               if (g_debug > 5)
                 module_printer (M0);
-              gc_pop_frame ();
               input = R1;
+              gc_pop_frame ();
               R1 = x;
               set_current_input_port (input);
+              if (program != cell_f)
+                {
+                  if (program->cdr != cell_f)
+                    R1 = cache_sources (R1);
+                  R1 = append2 (R1, cons (program, cell_nil));
+                }
+            begin_expand_primitive_load_cached:
               R1 = cons (cell_symbol_begin, R1);
               R2->car = R1;
+              gc_write_barrier (R2);
               R1 = R2;
               goto begin_expand_while;
               continue; /* FIXME: M2-PLanet */
@@ -909,12 +1802,22 @@ begin_expand:
       if (R1 != R2->car)
         {
           R2->car = R1;
+          gc_write_barrier (R2);
           R1 = R2;
           goto begin_expand_while;
           continue; /* FIXME: M2-PLanet */
         }
       R1 = R2;
+      if (cache_directory != 0)
+        cache_record (R1);
+    begin_expand_cached:
       expand_variable (R1->car, cell_nil);
+      x = lexical_expand (R1->car, cell_nil);
+      if (x != R1->car)
+        {
+          R1->car = x;
+          gc_write_barrier (R1);
+        }
       push_cc (R1->car, R1, R0, cell_vm_begin_expand_eval);
       goto eval;
     begin_expand_eval:
@@ -925,11 +1828,17 @@ begin_expand:
   goto vm_return;
 
 vm_if:
+  if (eval_leaf_p (R1->car) != 0)
+    {
+      x = eval_leaf (R1->car);
+      goto if_leaf;
+    }
   push_cc (R1->car, R1, R0, cell_vm_if_expr);
   goto eval;
 if_expr:
   x = R1;
   R1 = R2;
+if_leaf:
   if (x != cell_f)
     {
       R1 = R1->cdr->car;
@@ -943,6 +1852,118 @@ if_expr:
   R1 = cell_unspecified;
   goto vm_return;
 
+vm_and:
+  if (R1 == cell_nil)
+    {
+      R1 = cell_t;
+      goto vm_return;
+    }
+  while (R1->cdr != cell_nil)
+    {
+      if (eval_leaf_p (R1->car) != 0)
+        x = eval_leaf (R1->car);
+      else
+        {
+          push_cc (R1->car, R1, R0, cell_vm_eval_and);
+          goto eval;
+        eval_and:
+          x = R1;
+          R1 = R2;
+        }
+      if (x == cell_f)
+        {
+          R1 = x;
+          goto vm_return;
+        }
+      R1 = R1->cdr;
+    }
+  R1 = R1->car;
+  goto eval;
+
+vm_or:
+  if (R1 == cell_nil)
+    {
+      R1 = cell_f;
+      goto vm_return;
+    }
+  while (R1->cdr != cell_nil)
+    {
+      if (eval_leaf_p (R1->car) != 0)
+        x = eval_leaf (R1->car);
+      else
+        {
+          push_cc (R1->car, R1, R0, cell_vm_eval_or);
+          goto eval;
+        eval_or:
+          x = R1;
+          R1 = R2;
+        }
+      if (x != cell_f)
+        {
+          R1 = x;
+          goto vm_return;
+        }
+      R1 = R1->cdr;
+    }
+  R1 = R1->car;
+  goto eval;
+
+vm_cond:
+  while (R1 != cell_nil)
+    {
+      a = R1->car;
+      if (eval_leaf_p (a->car) != 0)
+        x = eval_leaf (a->car);
+      else
+        {
+          push_cc (a->car, R1, R0, cell_vm_eval_cond);
+          goto eval;
+        eval_cond:
+          x = R1;
+          R1 = R2;
+        }
+      if (x != cell_f)
+        {
+          body = R1->car->cdr;
+          if (body == cell_nil)
+            {
+              R1 = x;
+              goto vm_return;
+            }
+          if (body->car == cell_arrow)
+            {
+              x = cons (cell_symbol_quote, cons (x, cell_nil));
+              R1 = cons (body->cdr->car, cons (x, cell_nil));
+              goto eval;
+            }
+          R1 = body;
+          goto begin;
+        }
+      R1 = R1->cdr;
+    }
+  R1 = cell_unspecified;
+  goto vm_return;
+
+vm_case:
+  if (eval_leaf_p (R1->car) != 0)
+    x = eval_leaf (R1->car);
+  else
+    {
+      push_cc (R1->car, R1, R0, cell_vm_eval_case);
+      goto eval;
+    eval_case:
+      x = R1;
+      R1 = R2;
+    }
+  x = case_clause (x, R1->cdr);
+  if (x == cell_f)
+    {
+      R1 = x;
+      goto vm_return;
+    }
+  R1 = x->cdr;
+  goto begin;
+
 call_with_current_continuation:
   gc_push_frame ();
   x = make_continuation (g_continuations);
@@ -951,6 +1972,7 @@ call_with_current_continuation:
   for (i = g_stack; i < STACK_SIZE; i = i + 1)
     vector_set_x_ (v, i - g_stack, g_stack_array[i]);
   x->continuation = v;
+  gc_write_barrier (x);
   gc_pop_frame ();
   push_cc (cons (R1->car, cons (x, cell_nil)), x, R0, cell_vm_call_with_current_continuation2);
   goto apply;
@@ -959,13 +1981,29 @@ call_with_current_continuation2:
   for (i = g_stack; i < STACK_SIZE; i = i + 1)
     vector_set_x_ (v, i - g_stack, g_stack_array[i]);
   R2->continuation = v;
+  gc_write_barrier (R2);
+  goto vm_return;
+
+  /* An escape continuation only records the stack depth of its frame,
+     whose R2 is the continuation itself; invoking it drops the frames
+     above and returns from that frame.  */
+call_with_escape_continuation:
+  x = make_continuation (g_continuations);
+  g_continuations = g_continuations + 1;
+  push_cc (cons (R1->car, cons (x, cell_nil)), x, R0, cell_vm_call_with_escape_continuation2);
+  x->continuation = make_number (g_stack);
+  gc_write_barrier (x);
+  goto apply;
+call_with_escape_continuation2:
+  R2->continuation = cell_f;
+  gc_write_barrier (R2);
   goto vm_return;
 
 call_with_values:
   push_cc (cons (R1->car, cell_nil), R1, R0, cell_vm_call_with_values2);
   goto apply;
 call_with_values2:
-  if (R1->type == TVALUES)
+  if (cell_type (R1) == TVALUES)
     R1 = R1->cdr;
   R1 = cons (R2->cdr->car, R1);
   goto apply;
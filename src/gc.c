@@ -29,7 +29,31 @@
 #include <sys/time.h>
 #include <time.h>
 
+#if SYSTEM_LIBC
+#include <limits.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if MES_COMPACT_CELLS && !SYSTEM_LIBC
+#error MES_COMPACT_CELLS needs SYSTEM_LIBC
+#endif
+
 int g_dump_filedes;
+struct scm *gc_from;
+struct scm *gc_from_end;
+int gc_semispace;
+struct scm *gc_semispace_cells;
+long gc_space_bytes;
+struct scm *gc_arena_end;
+struct scm *gc_to;
+struct scm *gc_los;
+struct scm *gc_los_young;
+struct scm *gc_los_gray;
+int gc_los_marking;
+long gc_los_new;
+struct scm *gc_numbers;
+struct scm *gc_chars;
 
 #define M2_CELL_SIZE 1U
 // CONSTANT M2_CELL_SIZE 24
@@ -38,7 +62,63 @@ char *
 cell_bytes (struct scm *x)
 {
   char *p = cast_voidp_to_charp (x);
+#if MES_COMPACT_CELLS
+  return p + sizeof (long);
+#else
   return p + (2 * sizeof (long));
+#endif
+}
+
+#define CACHED_NUMBER_OFFSET 128
+// CONSTANT CACHED_NUMBER_OFFSET 128
+#define CACHED_NUMBERS 1152
+// CONSTANT CACHED_NUMBERS 1152
+#define CACHED_CHARS 256
+// CONSTANT CACHED_CHARS 256
+
+/* Small numbers and characters are immutable, they are allocated once
+   outside of the arena so that the garbage collector never sees them.
+   Compact cells need a type byte, gc_init reserves room for them right
+   behind the arena.  */
+void
+gc_init_cache ()
+{
+#if MES_COMPACT_CELLS
+  gc_numbers = gc_arena_end;
+  gc_chars = gc_numbers + (CACHED_NUMBERS * M2_CELL_SIZE);
+#else
+  gc_numbers = malloc (CACHED_NUMBERS * sizeof (struct scm));
+  gc_chars = malloc (CACHED_CHARS * sizeof (struct scm));
+#endif
+  struct scm *x;
+  long i;
+  for (i = 0; i < CACHED_NUMBERS; i = i + 1)
+    {
+      x = cell_ref (gc_numbers, i);
+      set_cell_type (x, TNUMBER);
+      x->length = 0;
+      x->value = i - CACHED_NUMBER_OFFSET;
+    }
+  for (i = 0; i < CACHED_CHARS; i = i + 1)
+    {
+      x = cell_ref (gc_chars, i);
+      set_cell_type (x, TCHAR);
+      x->length = 0;
+      x->value = i;
+    }
+}
+
+/* The cache of expanded forms is keyed by address; once cells have
+   moved it would give false hits.  */
+void
+gc_clear_expanded ()
+{
+  long i;
+  if (g_expanded_count == 0)
+    return;
+  for (i = 0; i < EXPANDED_SIZE; i = i + 1)
+    g_expanded[i] = 0;
+  g_expanded_count = 0;
 }
 
 #define U10 10U
@@ -83,13 +163,101 @@ gc_init ()
   p = getenv ("MES_MAX_STRING");
   if (p != 0)
     MAX_STRING = atoi (p);
+  NURSERY_SIZE = 0;
+  p = getenv ("MES_NURSERY");
+  if (p != 0)
+    NURSERY_SIZE = atoi (p);
+  gc_semispace = 0;
+  p = getenv ("MES_SEMISPACE");
+  if (p != 0)
+    gc_semispace = atoi (p);
+#if SYSTEM_LIBC
+  LOS_THRESHOLD = 1024;
+#else
+  LOS_THRESHOLD = 0;            /* free is a no-op. */
+#endif
+  p = getenv ("MES_LOS_THRESHOLD");
+  if (p != 0)
+    LOS_THRESHOLD = atoi (p);
+#if MES_COMPACT_CELLS
+  /* A large object would have no type bytes.  */
+  LOS_THRESHOLD = 0;
+#endif
 
+#if SYSTEM_LIBC
+  /* Reserve the address space for the largest arena, and news, up
+     front.  Pages are only committed when the heap first touches them,
+     so growing the arena needs no copying.  */
+  long max_cells = ARENA_SIZE + JAM_SIZE;
+  if (max_cells < MAX_ARENA_SIZE)
+    max_cells = MAX_ARENA_SIZE;
+  long spaces = 2;
+  if (gc_semispace != 0)
+    spaces = 4;
+  long cell_size = sizeof (struct scm);
+  if (max_cells > LONG_MAX / (spaces * cell_size))
+    max_cells = LONG_MAX / (spaces * cell_size);
+  long cache_bytes = 0;
+#if MES_COMPACT_CELLS
+  cache_bytes = (CACHED_NUMBERS + CACHED_CHARS) * cell_size;
+#endif
+  /* A 32-bit address space may not hold that much; settle for less.  */
+  long reserve_bytes = spaces * max_cells * cell_size;
+  g_arena = mmap (0, reserve_bytes + cache_bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  while (g_arena == MAP_FAILED && max_cells > GC_SAFETY)
+    {
+      max_cells = max_cells / 2;
+      reserve_bytes = spaces * max_cells * cell_size;
+      g_arena = mmap (0, reserve_bytes + cache_bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+  if (g_arena == MAP_FAILED)
+    {
+      eputs ("mmap failed: ");
+      eputs (ltoa (reserve_bytes));
+      eputs ("\n");
+      exit (1);
+    }
+#if MES_COMPACT_CELLS
+  /* The type of the cell at address X is g_cell_types[X / cell_size],
+     one byte for every cell of the reservation.  */
+  char *types = mmap (0, (reserve_bytes + cache_bytes) / cell_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (types == MAP_FAILED)
+    {
+      eputs ("mmap failed: ");
+      eputs (ltoa ((reserve_bytes + cache_bytes) / cell_size));
+      eputs ("\n");
+      exit (1);
+    }
+  g_cell_types = types - (cast_voidp_to_long (g_arena) / cell_size);
+#endif
+  if (MAX_ARENA_SIZE > max_cells)
+    MAX_ARENA_SIZE = max_cells;
+  if (ARENA_SIZE + JAM_SIZE > max_cells)
+    {
+      ARENA_SIZE = max_cells - max_cells / U10;
+      JAM_SIZE = ARENA_SIZE / U10;
+      GC_SAFETY = ARENA_SIZE / U100;
+    }
+  gc_space_bytes = 2 * max_cells * cell_size;
+  g_stack_array = malloc (STACK_SIZE * sizeof (struct scm *));
+  gc_arena_end = cast_charp_to_scmp (g_arena + reserve_bytes);
+#else
   long arena_bytes = (ARENA_SIZE + JAM_SIZE) * sizeof (struct scm);
-  long alloc_bytes = arena_bytes + (STACK_SIZE * sizeof (struct scm));
-
+  gc_space_bytes = arena_bytes;
+  long stack_offset = arena_bytes;
+  if (gc_semispace != 0)
+    stack_offset = arena_bytes * 2;
+  long alloc_bytes = stack_offset + (STACK_SIZE * sizeof (struct scm));
   g_arena = malloc (alloc_bytes);
+  g_stack_array = cast_charp_to_scmpp (g_arena + stack_offset);
+  gc_arena_end = cast_charp_to_scmp (g_arena + stack_offset);
+#endif
   g_cells = cast_charp_to_scmp (g_arena);
-  g_stack_array = cast_charp_to_scmpp (g_arena + arena_bytes);
+  if (gc_semispace != 0)
+    gc_semispace_cells = cast_charp_to_scmp (g_arena + gc_space_bytes) + M2_CELL_SIZE;
 
   /* The vector that holds the arenea. */
   cell_arena = g_cells;
@@ -98,17 +266,31 @@ gc_init ()
 
   g_cells = g_cells + M2_CELL_SIZE; /* Hmm? */
 
-  cell_arena->type = TVECTOR;
+  set_cell_type (cell_arena, TVECTOR);
   cell_arena->length = 1000;
   cell_arena->vector = cell_zero;
 
-  cell_zero->type = TCHAR;
+  set_cell_type (cell_zero, TCHAR);
   cell_zero->value = 'c';
 
   g_free = g_cells + M2_CELL_SIZE;
 
   /* FIXME: remove MES_MAX_STRING, grow dynamically. */
   g_buf = malloc (MAX_STRING);
+  gc_init_cache ();
+  g_expanded = malloc (EXPANDED_SIZE * sizeof (struct scm *));
+  g_expanded_count = 1;
+  gc_clear_expanded ();
+
+  /* The nursery only starts after the first full collection, until
+     then g_nursery == 0 keeps the write barrier a no-op. */
+  g_nursery = 0;
+  g_remembered = 0;
+  if (NURSERY_SIZE != 0)
+    {
+      REMEMBERED_SIZE = NURSERY_SIZE;
+      g_remembered_set = malloc (REMEMBERED_SIZE * sizeof (struct scm *));
+    }
 }
 
 long
@@ -140,6 +322,8 @@ gc_stats ()
   arena_used = arena_used / M2_CELL_SIZE;
   size_t arena_free = ARENA_SIZE - arena_used;
   struct scm *r = cell_nil;
+  r =  acons (cstring_to_symbol ("gc-major-count"), make_number (gc_count - gc_minor_count), r);
+  r =  acons (cstring_to_symbol ("gc-minor-count"), make_number (gc_minor_count), r);
   r =  acons (cstring_to_symbol ("gc-count"), make_number (gc_count), r);
   r =  acons (cstring_to_symbol ("gc-time"), make_number (gc_time), r);
   r =  acons (cstring_to_symbol ("arena-free"), make_number (arena_free), r);
@@ -147,16 +331,72 @@ gc_stats ()
   return r;
 }
 
+/* Grow the arena to hold I cells, or fail with MSG.  */
+void
+gc_grow_arena (long i, char *msg)
+{
+#if SYSTEM_LIBC
+  while (i > ARENA_SIZE && ARENA_SIZE + JAM_SIZE < MAX_ARENA_SIZE)
+    gc_up_arena ();
+#endif
+  if (i > ARENA_SIZE)
+    assert_msg (0, msg);
+}
+
+/* A large object lives outside of the arena, behind a two cell header
+   holding its mark, the next large object, the next gray large object
+   and its size.  Large objects are marked instead of copied. */
+struct scm *
+gc_los_alloc (long n)
+{
+  struct scm *h = malloc ((n + 2) * sizeof (struct scm));
+  if (h == 0)
+    assert_msg (0, "gc_los_alloc: out of memory");
+  set_cell_type (h, 0);
+  h->car = gc_los;
+  h->cdr = 0;
+  gc_los = h;
+  h = h + M2_CELL_SIZE;
+  set_cell_type (h, TNUMBER);
+  h->length = 0;
+  h->value = n;
+  gc_los_new = gc_los_new + n;
+  return h + M2_CELL_SIZE;
+}
+
+int
+gc_los_p (struct scm *x)
+{
+  if (x < cast_charp_to_scmp (g_arena) || x >= gc_arena_end)
+    return 1;
+  return 0;
+}
+
+void
+gc_los_mark (struct scm *x)             /*:((internal)) */
+{
+  if (gc_los_marking == 0)
+    return;
+  struct scm *h = x - (2 * M2_CELL_SIZE);
+  if (cell_type (h) != 0)
+    return;
+  set_cell_type (h, 1);
+  h->cdr = gc_los_gray;
+  gc_los_gray = h;
+}
+
 struct scm *
 alloc (long n)
 {
+  if (LOS_THRESHOLD != 0 && n >= LOS_THRESHOLD)
+    return gc_los_alloc (n);
   struct scm *x = g_free;
   g_free = g_free + (n * M2_CELL_SIZE);
   long i = g_free - g_cells;
   i = i / M2_CELL_SIZE;
 
   if (i > ARENA_SIZE)
-    assert_msg (0, "alloc: out of memory");
+    gc_grow_arena (i, "alloc: out of memory");
   return x;
 }
 
@@ -168,8 +408,8 @@ make_cell (long type, struct scm *car, struct scm *cdr)
   long i = g_free - g_cells;
   i = i / M2_CELL_SIZE;
   if (i > ARENA_SIZE)
-    assert_msg (0, "make_cell: out of memory");
-  x->type = type;
+    gc_grow_arena (i, "make_cell: out of memory");
+  set_cell_type (x, type);
   x->car = car;
   x->cdr = cdr;
   return x;
@@ -183,8 +423,8 @@ make_pointer_cell (long type, long car, void *cdr)
   long i = g_free - g_cells;
   i = i / M2_CELL_SIZE;
   if (i > ARENA_SIZE)
-    assert_msg (0, "make_pointer_cell: out of memory");
-  x->type = type;
+    gc_grow_arena (i, "make_pointer_cell: out of memory");
+  set_cell_type (x, type);
   x->length = car;
   x->cdr = cdr;
   return x;
@@ -198,8 +438,8 @@ make_value_cell (long type, long car, long cdr)
   long i = g_free - g_cells;
   i = i / M2_CELL_SIZE;
   if (i > ARENA_SIZE)
-    assert_msg (0, "make_value_cell: out of memory");
-  x->type = type;
+    gc_grow_arena (i, "make_value_cell: out of memory");
+  set_cell_type (x, type);
   x->length = car;
   x->value = cdr;
   return x;
@@ -208,7 +448,7 @@ make_value_cell (long type, long car, long cdr)
 void
 copy_cell (struct scm *to, struct scm *from)
 {
-  to->type = from->type;
+  set_cell_type (to, cell_type (from));
   to->car = from->car;
   to->cdr = from->cdr;
 }
@@ -234,7 +474,11 @@ cons (struct scm *x, struct scm *y)
 size_t
 bytes_cells (size_t length)
 {
+#if MES_COMPACT_CELLS
+  return (sizeof (long) + length + sizeof (struct scm) - 1) / sizeof (struct scm);
+#else
   return (sizeof (long) + sizeof (long) + length - 1 + sizeof (struct scm *)) / sizeof (struct scm *);
+#endif
 }
 
 struct scm *
@@ -242,12 +486,12 @@ make_bytes (char const *s, size_t length)
 {
   size_t size = bytes_cells (length);
   struct scm *x = alloc (size);
-  x->type = TBYTES;
+  set_cell_type (x, TBYTES);
   x->length = length;
   char *p = cell_bytes (x);
   if (length == 0)
     p[0] = 0;
-  else
+  else if (s != 0)
     memcpy (p, s, length);
 
   return x;
@@ -256,6 +500,8 @@ make_bytes (char const *s, size_t length)
 struct scm *
 make_char (int n)
 {
+  if (n >= 0 && n < CACHED_CHARS)
+    return cell_ref (gc_chars, n);
   return make_value_cell (TCHAR, 0, n);
 }
 
@@ -274,6 +520,9 @@ make_macro (struct scm *name, struct scm *x)    /*:((internal)) */
 struct scm *
 make_number (long n)
 {
+  long i = n + CACHED_NUMBER_OFFSET;
+  if (i >= 0 && i < CACHED_NUMBERS)
+    return cell_ref (gc_numbers, i);
   return make_value_cell (TNUMBER, 0, n);
 }
 
@@ -303,7 +552,24 @@ make_string0 (char const *s)
 struct scm *
 make_string_port (struct scm *x)        /*:((internal)) */
 {
-  return make_pointer_cell (TPORT, -length__ (g_ports) - 2, x);
+  /* A string port reads X through a cursor that it owns, so it must
+     not be a cached number.  */
+  struct scm *cursor = make_value_cell (TNUMBER, 0, 0);
+  g_port_count = g_port_count + 1;
+  return make_pointer_cell (TPORT, -g_port_count - 1, cons (x, cursor));
+}
+
+struct scm *
+make_string_output_port ()              /*:((internal)) */
+{
+  /* The port grows BUFFER as it is written to and keeps the number of
+     bytes written in a number cell that it owns.  */
+  struct scm *buffer = make_bytes (0, 64);
+  struct scm *count = make_value_cell (TNUMBER, 0, 0);
+  char *p = cell_bytes (buffer);
+  p[0] = 0;
+  g_port_count = g_port_count + 1;
+  return make_pointer_cell (TPORT, -g_port_count - 1, cons (buffer, count));
 }
 
 void
@@ -315,18 +581,20 @@ gc_init_news ()
 
   g_news = g_news + M2_CELL_SIZE;
 
-  ncell_arena->type = TVECTOR;
+  set_cell_type (ncell_arena, TVECTOR);
   ncell_arena->length = cell_arena->length;
   ncell_arena->vector = g_news;
 
-  ncell_zero->type = TCHAR;
+  set_cell_type (ncell_zero, TCHAR);
   ncell_zero->value = 'n';
 }
 
 void
 gc_up_arena ()
 {
+#if !SYSTEM_LIBC
   long old_arena_bytes = (ARENA_SIZE + JAM_SIZE) * sizeof (struct scm);
+#endif
   if (ARENA_SIZE / 2 < MAX_ARENA_SIZE / 4)
     {
       ARENA_SIZE = ARENA_SIZE * 2;
@@ -335,6 +603,9 @@ gc_up_arena ()
     }
   else
     ARENA_SIZE = MAX_ARENA_SIZE - JAM_SIZE;
+#if SYSTEM_LIBC
+  /* The address space was reserved by gc_init, no need to copy.  */
+#else
   long arena_bytes = (ARENA_SIZE + JAM_SIZE) * sizeof (struct scm);
   long stack_offset = (arena_bytes * 2);
   long realloc_bytes = (arena_bytes * 2) + (STACK_SIZE * sizeof (struct scm));
@@ -353,11 +624,34 @@ gc_up_arena ()
     }
   g_cells = p;
   memcpy (p + stack_offset, p + old_arena_bytes, STACK_SIZE * sizeof (struct scm *));
+  gc_arena_end = cast_charp_to_scmp (p + stack_offset);
   g_cells = g_cells + M2_CELL_SIZE;
+#endif
+}
+
+/* Give the pages of the unused cells in [start, end) back to the
+   system.  */
+void
+gc_release (struct scm *start, struct scm *end)
+{
+#if SYSTEM_LIBC
+  long page = sysconf (_SC_PAGESIZE);
+  char *p = cast_scmp_to_charp (start);
+  long s = cast_scmp_to_long (start);
+  long e = cast_scmp_to_long (end);
+  long head = (page - (s % page)) % page;
+  p = p + head;
+  s = s + head;
+  e = e - (e % page);
+  if (s < e)
+    madvise (p, e - s, MADV_DONTNEED);
+#endif
 }
 
 /* A pointer relocating memcpy for pointer cells to avoid using only
-   half of the allocated cells.
+   half of the allocated cells.  Only pointers into the copied range
+   are relocated, a minor collection copies cells that still point into
+   the old generation.
 
    For number based cells a simply memcpy could be used, as number
    references are relative.
@@ -372,6 +666,8 @@ gc_cellcpy (struct scm *dest, struct scm *src, size_t n)
   void *p = src;
   void *q = dest;
   long dist = p - q;
+  long lo = cast_scmp_to_long (src);
+  long hi = cast_scmp_to_long (src + (n * M2_CELL_SIZE));
   long t;
   long a;
   long d;
@@ -379,20 +675,21 @@ gc_cellcpy (struct scm *dest, struct scm *src, size_t n)
   int c;
   while (n != 0)
     {
-      t = src->type;
+      t = cell_type (src);
       a = src->car_value;
       d = src->cdr_value;
-      dest->type = t;
+      set_cell_type (dest, t);
       if (t == TBROKEN_HEART)
         assert_msg (0, "gc_cellcpy: broken heart");
-      if (t == TMACRO
-          || t == TPAIR
-          || t == TREF
-          || t == TVARIABLE)
+      if ((t == TMACRO
+           || t == TPAIR
+           || t == TREF
+           || t == TVARIABLE)
+          && a >= lo && a < hi)
         dest->car_value = a - dist;
       else
         dest->car_value = a;
-      if (t == TBYTES
+      if ((t == TBYTES
           || t == TCLOSURE
           || t == TCONTINUATION
           || t == TKEYWORD
@@ -405,6 +702,7 @@ gc_cellcpy (struct scm *dest, struct scm *src, size_t n)
           || t == TSYMBOL
           || t == TVALUES
           || t == TVECTOR)
+          && d >= lo && d < hi)
         dest->cdr_value = d - dist;
       else
         dest->cdr_value = d;
@@ -444,40 +742,234 @@ gc_cellcpy (struct scm *dest, struct scm *src, size_t n)
 }
 
 /* We do not actually flip cells and news, instead we move news back to
-   cells. */
+   cells.  Set MES_SEMISPACE to flip them, see gc_semispace_. */
 void
 gc_flip ()
 {
+  gc_to = g_cells;
+  struct scm *h;
+  for (h = gc_los; h != 0; h = h->car)
+    if (cell_type (h) != 0)
+      gc_los_relocate (h);
+
   if (g_free - g_news > JAM_SIZE)
     JAM_SIZE = ((g_free - g_news) * 3) / 2;
 
   cell_arena = g_cells - M2_CELL_SIZE; /* For debugging. */
   gc_cellcpy (g_cells, g_news, (g_free - g_news) / M2_CELL_SIZE);
 
+  /* Roots may point to cached numbers and characters outside news. */
+  g_symbols = gc_relocate (g_symbols);
+  g_macros = gc_relocate (g_macros);
+  g_ports = gc_relocate (g_ports);
+  g_jit_constants = gc_relocate (g_jit_constants);
+  M0 = gc_relocate (M0);
+
+  long i;
+  for (i = g_stack; i < STACK_SIZE; i = i + 1)
+    g_stack_array[i] = gc_relocate (g_stack_array[i]);
+
   long dist = g_news - g_cells;
+  struct scm *end = g_free;
   g_free = g_free - dist;
-  g_symbols = g_symbols - dist;
-  g_macros = g_macros - dist;
-  g_ports = g_ports - dist;
-  M0 = M0 - dist;
+  /* News beyond the arena is not touched again until the next gc.  */
+  struct scm *start = g_cells + (ARENA_SIZE * M2_CELL_SIZE);
+  if (start < g_free)
+    start = g_free;
+  gc_release (start, end);
 
+  if (g_debug > 2)
+    gc_stats_ (";;; => jam");
+}
+
+/* Relocate X when it points to a survivor that is being moved from
+   news back to GC_TO. */
+struct scm *
+gc_relocate (struct scm *x)             /*:((internal)) */
+{
+  if (x >= g_news && x < g_free)
+    return x - (g_news - gc_to);
+  return x;
+}
+
+void
+gc_relocate_cell (struct scm *x)        /*:((internal)) */
+{
+  long t = cell_type (x);
+  /* *INDENT-OFF* */
+  if (t == TMACRO
+      || t == TPAIR
+      || t == TREF
+      || t == TVARIABLE)
+    /* *INDENT-ON* */
+    x->car = gc_relocate (x->car);
+  /* *INDENT-OFF* */
+  if (t == TCLOSURE
+      || t == TCONTINUATION
+      || t == TKEYWORD
+      || t == TMACRO
+      || t == TPAIR
+      || t == TPORT
+      || t == TSPECIAL
+      || t == TSTRING
+      || t == TSTRUCT
+      || t == TSYMBOL
+      || t == TVALUES
+      || t == TVECTOR)
+    /* *INDENT-ON* */
+    x->cdr = gc_relocate (x->cdr);
+}
+
+/* Scan the cells of the large object H.  */
+void
+gc_los_scan (struct scm *h)             /*:((internal)) */
+{
+  struct scm *s = h + (2 * M2_CELL_SIZE);
+  struct scm *end = s + (cell_ref (h, 1)->value * M2_CELL_SIZE);
+  while (s < end)
+    s = gc_scan (s);
+}
+
+/* Relocate the cells of the large object H.  */
+void
+gc_los_relocate (struct scm *h)         /*:((internal)) */
+{
+  struct scm *s = h + (2 * M2_CELL_SIZE);
+  struct scm *end = s + (cell_ref (h, 1)->value * M2_CELL_SIZE);
+  while (s < end)
+    {
+      if (cell_type (s) == TBYTES)
+        s = end;
+      else
+        {
+          gc_relocate_cell (s);
+          s = s + M2_CELL_SIZE;
+        }
+    }
+}
+
+/* Free the large objects that were not marked.  */
+void
+gc_los_sweep ()
+{
+  struct scm *h = gc_los;
+  struct scm *prev = 0;
+  struct scm *next;
+  while (h != 0)
+    {
+      next = h->car;
+      if (cell_type (h) == 0)
+        {
+          if (prev == 0)
+            gc_los = next;
+          else
+            prev->car = next;
+          free (h);
+        }
+      else
+        {
+          set_cell_type (h, 0);
+          prev = h;
+        }
+      h = next;
+    }
+  gc_los_young = gc_los;
+  gc_los_new = 0;
+}
+
+/* Move the survivors of a minor collection from news back to the
+   nursery, and update the references to them from the roots and from
+   the old generation. */
+void
+gc_minor_flip ()
+{
+  gc_to = g_nursery;
+  struct scm *s;
+  for (s = gc_los; s != gc_los_young; s = s->car)
+    gc_los_relocate (s);
+  gc_los_young = gc_los;
+  for (s = cell_nil; s < g_symbol_max; s = s + M2_CELL_SIZE)
+    gc_relocate_cell (s);
   long i;
+  for (i = 0; i < g_remembered; i = i + 1)
+    gc_relocate_cell (g_remembered_set[i]);
+
+  g_symbols = gc_relocate (g_symbols);
+  g_macros = gc_relocate (g_macros);
+  g_ports = gc_relocate (g_ports);
+  g_jit_constants = gc_relocate (g_jit_constants);
+  M0 = gc_relocate (M0);
   for (i = g_stack; i < STACK_SIZE; i = i + 1)
-    g_stack_array[i] = g_stack_array[i] - dist;
+    g_stack_array[i] = gc_relocate (g_stack_array[i]);
+
+  gc_cellcpy (g_nursery, g_news, (g_free - g_news) / M2_CELL_SIZE);
+  long dist = g_news - g_nursery;
+  g_free = g_free - dist;
+  g_nursery = g_free;
+  g_remembered = 0;
 
   if (g_debug > 2)
-    gc_stats_ (";;; => jam");
+    gc_stats_ (";;; => minor");
+}
+
+/* Record X, an old cell that is being mutated, so that a minor
+   collection finds the young cells it may now point to. */
+void
+gc_write_barrier (struct scm *x)
+{
+  if (x >= g_nursery && x < g_free)
+    return;
+  if (g_remembered > REMEMBERED_SIZE)
+    return;
+  if (g_remembered != 0)
+    if (g_remembered_set[g_remembered - 1] == x)
+      return;
+  if (g_remembered == REMEMBERED_SIZE)
+    {
+      /* Overflow: the next collection must be a major one. */
+      g_remembered = REMEMBERED_SIZE + 1;
+      return;
+    }
+  g_remembered_set[g_remembered] = x;
+  g_remembered = g_remembered + 1;
+}
+
+/* Copy the rest of a list right behind its first pair, so that the
+   spine of a list stays contiguous instead of being spread breadth
+   first over news.  */
+void
+gc_copy_spine (struct scm *x)           /*:((internal)) */
+{
+  struct scm *new;
+  while (x >= gc_from && x < gc_from_end && cell_type (x) == TPAIR)
+    {
+      new = g_free;
+      g_free = g_free + M2_CELL_SIZE;
+      copy_cell (new, x);
+      set_cell_type (x, TBROKEN_HEART);
+      x->car = new;
+      x = new->cdr;
+    }
 }
 
 struct scm *
 gc_copy (struct scm *old)               /*:((internal)) */
 {
-  if (old->type == TBROKEN_HEART)
+  if (old < gc_from || old >= gc_from_end)
+    {
+      if (cell_type (old) == TBYTES && gc_los_marking != 0 && gc_los_p (old) != 0)
+        gc_los_mark (old);
+      return old;
+    }
+  if (cell_type (old) == TBROKEN_HEART)
     return old->car;
   struct scm *new = g_free;
   g_free = g_free + M2_CELL_SIZE;
   copy_cell (new, old);
-  if (new->type == TSTRUCT || new->type == TVECTOR)
+  if ((cell_type (new) == TSTRUCT || cell_type (new) == TVECTOR)
+      && gc_los_p (old->vector) != 0)
+    gc_los_mark (old->vector);
+  else if (cell_type (new) == TSTRUCT || cell_type (new) == TVECTOR)
     {
       new->vector = g_free;
       long i;
@@ -487,7 +979,7 @@ gc_copy (struct scm *old)               /*:((internal)) */
           g_free = g_free + M2_CELL_SIZE;
         }
     }
-  else if (new->type == TBYTES)
+  else if (cell_type (new) == TBYTES)
     {
       char const *src = cell_bytes (old);
       char *dest = cell_bytes (new);
@@ -511,8 +1003,10 @@ gc_copy (struct scm *old)               /*:((internal)) */
           eputs ("\n");
         }
     }
-  old->type = TBROKEN_HEART;
+  set_cell_type (old, TBROKEN_HEART);
   old->car = new;
+  if (cell_type (new) == TPAIR)
+    gc_copy_spine (new->cdr);
   return new;
 }
 
@@ -530,60 +1024,81 @@ gc_relocate_cdr (struct scm *new, struct scm *cdr)      /*:((internal)) */
   return cell_unspecified;
 }
 
-void
-gc_loop (struct scm *scan)
+/* Copy the cells that SCAN points to, return the next cell to scan. */
+struct scm *
+gc_scan (struct scm *scan)              /*:((internal)) */
 {
   struct scm *car;
   struct scm *cdr;
-  long t;
-  while (scan < g_free)
+  long t = cell_type (scan);
+  if (t == TBROKEN_HEART)
+    assert_msg (0, "gc_scan: broken heart");
+  /* *INDENT-OFF* */
+  if (t == TMACRO
+      || t == TPAIR
+      || t == TREF
+      || t == TVARIABLE)
+    /* *INDENT-ON* */
     {
-      t = scan->type;
-      if (t == TBROKEN_HEART)
-        assert_msg (0, "gc_loop: broken heart");
-      /* *INDENT-OFF* */
-      if (t == TMACRO
-          || t == TPAIR
-          || t == TREF
-          || t == TVARIABLE)
-        /* *INDENT-ON* */
-        {
-          car = gc_copy (scan->car);
-          gc_relocate_car (scan, car);
-        }
-      /* *INDENT-OFF* */
-      if (t == TCLOSURE
-          || t == TCONTINUATION
-          || t == TKEYWORD
-          || t == TMACRO
-          || t == TPAIR
-          || t == TPORT
-          || t == TSPECIAL
-          || t == TSTRING
-          /*|| t == TSTRUCT handled by gc_copy */
-          || t == TSYMBOL
-          || t == TVALUES
-          /*|| t == TVECTOR handled by gc_copy */
-          )
-        /* *INDENT-ON* */
+      car = gc_copy (scan->car);
+      gc_relocate_car (scan, car);
+    }
+  /* *INDENT-OFF* */
+  if (t == TCLOSURE
+      || t == TCONTINUATION
+      || t == TKEYWORD
+      || t == TMACRO
+      || t == TPAIR
+      || t == TPORT
+      || t == TSPECIAL
+      || t == TSTRING
+      /*|| t == TSTRUCT handled by gc_copy */
+      || t == TSYMBOL
+      || t == TVALUES
+      /*|| t == TVECTOR handled by gc_copy */
+      )
+    /* *INDENT-ON* */
+    {
+      cdr = gc_copy (scan->cdr);
+      gc_relocate_cdr (scan, cdr);
+    }
+  if (t == TBYTES)
+    return scan + (bytes_cells (scan->length) * M2_CELL_SIZE);
+  return scan + M2_CELL_SIZE;
+}
+
+void
+gc_loop (struct scm *scan)
+{
+  struct scm *h;
+  while (scan < g_free || gc_los_gray != 0)
+    {
+      while (scan < g_free)
+        scan = gc_scan (scan);
+      if (gc_los_gray != 0)
         {
-          cdr = gc_copy (scan->cdr);
-          gc_relocate_cdr (scan, cdr);
+          h = gc_los_gray;
+          gc_los_gray = h->cdr;
+          gc_los_scan (h);
         }
-      if (t == TBYTES)
-        scan = scan + (bytes_cells (scan->length) * M2_CELL_SIZE);
-      else
-        scan = scan + M2_CELL_SIZE;
     }
-  gc_flip ();
 }
 
 struct scm *
 gc_check ()
 {
-  long used = ((g_free - g_cells) / M2_CELL_SIZE) + GC_SAFETY;
+  long used = ((g_free - g_cells) / M2_CELL_SIZE) + gc_los_new + GC_SAFETY;
   if (used >= ARENA_SIZE)
     return gc ();
+  if (NURSERY_SIZE != 0)
+    {
+      /* Everything allocated before the first safepoint is old. */
+      if (g_nursery == 0)
+        g_nursery = g_free;
+      long young = (g_free - g_nursery) / M2_CELL_SIZE;
+      if (young >= NURSERY_SIZE)
+        return gc_minor ();
+    }
   return cell_unspecified;
 }
 
@@ -602,6 +1117,7 @@ gc_ ()
     }
   g_free = g_news + M2_CELL_SIZE;
 
+#if !SYSTEM_LIBC
   if (ARENA_SIZE < MAX_ARENA_SIZE
       && cast_voidp_to_charp (g_cells) == g_arena + M2_CELL_SIZE)
     {
@@ -621,6 +1137,9 @@ gc_ ()
         }
       gc_up_arena ();
     }
+#endif
+  gc_from = g_cells;
+  gc_from_end = g_news;
 
   struct scm *new_cell_nil = g_free;
   struct scm *s;
@@ -630,6 +1149,7 @@ gc_ ()
   g_symbols = gc_copy (g_symbols);
   g_macros = gc_copy (g_macros);
   g_ports = gc_copy (g_ports);
+  g_jit_constants = gc_copy (g_jit_constants);
   M0 = gc_copy (M0);
 
   long i;
@@ -637,6 +1157,134 @@ gc_ ()
     copy_stack (i, gc_copy (g_stack_array[i]));
 
   gc_loop (new_cell_nil);
+  gc_flip ();
+}
+
+/* A true semispace flip: copy the live cells to the other semispace
+   and continue allocating there.  The symbols stay put at the start of
+   the first semispace, so they are scanned instead of copied. */
+void
+gc_semispace_ ()
+{
+  struct scm *cells = cast_charp_to_scmp (g_arena) + M2_CELL_SIZE;
+  struct scm *to = cells;
+  struct scm *news = g_symbol_max;
+  gc_from = g_cells;
+  if (g_cells == cells)
+    {
+      to = gc_semispace_cells;
+      news = to + M2_CELL_SIZE;
+      gc_from = g_symbol_max;
+    }
+  gc_from_end = g_free;
+  if (g_debug == 2)
+    eputs (".");
+
+  if (g_debug > 2)
+    {
+      gc_stats_ (";;; gc");
+      eputs (";;; free: [");
+      eputs (ltoa (ARENA_SIZE - gc_free ()));
+      eputs ("]...");
+    }
+  g_news = news;
+  g_free = news;
+
+  struct scm *s;
+  for (s = cell_nil; s < g_symbol_max; s = s + M2_CELL_SIZE)
+    gc_scan (s);
+
+  g_symbols = gc_copy (g_symbols);
+  g_macros = gc_copy (g_macros);
+  g_ports = gc_copy (g_ports);
+  g_jit_constants = gc_copy (g_jit_constants);
+  M0 = gc_copy (M0);
+
+  long i;
+  for (i = g_stack; i < STACK_SIZE; i = i + 1)
+    copy_stack (i, gc_copy (g_stack_array[i]));
+
+  gc_loop (news);
+  g_cells = to;
+
+  if (g_debug > 2)
+    gc_stats_ (";;; => flip");
+}
+
+/* A minor collection only copies the live cells of the nursery,
+   [g_nursery, g_free), using the symbols, the registers, the stack and
+   the remembered set as roots. */
+void
+gc_minor_ ()
+{
+  if (g_debug == 2)
+    eputs (",");
+  if (g_debug > 2)
+    {
+      gc_stats_ (";;; minor gc");
+      eputs (";;; young: [");
+      eputs (ltoa ((g_free - g_nursery) / M2_CELL_SIZE));
+      eputs ("]...");
+    }
+  g_news = g_free;
+  gc_from = g_nursery;
+  gc_from_end = g_news;
+
+  struct scm *s;
+  for (s = cell_nil; s < g_symbol_max; s = s + M2_CELL_SIZE)
+    gc_scan (s);
+
+  g_symbols = gc_copy (g_symbols);
+  g_macros = gc_copy (g_macros);
+  g_ports = gc_copy (g_ports);
+  g_jit_constants = gc_copy (g_jit_constants);
+  M0 = gc_copy (M0);
+
+  long i;
+  for (i = g_stack; i < STACK_SIZE; i = i + 1)
+    copy_stack (i, gc_copy (g_stack_array[i]));
+  for (i = 0; i < g_remembered; i = i + 1)
+    gc_scan (g_remembered_set[i]);
+  for (s = gc_los; s != gc_los_young; s = s->car)
+    gc_los_scan (s);
+
+  gc_loop (g_news);
+  gc_minor_flip ();
+}
+
+void
+gc_timer_start ()
+{
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, gc_start_time);
+}
+
+void
+gc_timer_stop ()
+{
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, gc_end_time);
+  long time = seconds_and_nanoseconds_to_long
+    (gc_end_time->tv_sec - gc_start_time->tv_sec,
+     gc_end_time->tv_nsec - gc_start_time->tv_nsec);
+  gc_time = gc_time + time;
+  gc_count = gc_count + 1;
+}
+
+struct scm *
+gc_minor ()
+{
+  long used = (g_free - g_cells) / M2_CELL_SIZE;
+  long young = (g_free - g_nursery) / M2_CELL_SIZE;
+  if (g_remembered > REMEMBERED_SIZE
+      || used + young + GC_SAFETY >= ARENA_SIZE + JAM_SIZE)
+    return gc ();
+  gc_timer_start ();
+  gc_push_frame ();
+  gc_minor_ ();
+  gc_pop_frame ();
+  gc_clear_expanded ();
+  gc_timer_stop ();
+  gc_minor_count = gc_minor_count + 1;
+  return cell_unspecified;
 }
 
 struct scm *
@@ -653,16 +1301,32 @@ gc ()
       write_error_ (R0);
       eputs ("\n");
     }
-  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, gc_start_time);
+  gc_timer_start ();
   gc_push_frame ();
-  gc_ ();
+  gc_los_marking = 1;
+  gc_los_gray = 0;
+  if (gc_semispace != 0)
+    gc_semispace_ ();
+  else
+    gc_ ();
+  gc_los_marking = 0;
+  gc_los_sweep ();
   gc_pop_frame ();
-  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, gc_end_time);
-  long time = seconds_and_nanoseconds_to_long
-    (gc_end_time->tv_sec - gc_start_time->tv_sec,
-     gc_end_time->tv_nsec - gc_start_time->tv_nsec);
-  gc_time = gc_time + time;
-  gc_count = gc_count + 1;
+  gc_clear_expanded ();
+#if SYSTEM_LIBC
+  /* Growing the reserved arena is cheap, grow it only when the live
+     cells fill half of it.  */
+  if (ARENA_SIZE < MAX_ARENA_SIZE && gc_free () > ARENA_SIZE / 2)
+    {
+      if (g_debug == 2)
+        eputs ("+");
+      gc_up_arena ();
+    }
+#endif
+  gc_timer_stop ();
+  g_remembered = 0;
+  if (NURSERY_SIZE != 0)
+    g_nursery = g_free;
   if (g_debug > 5)
     {
       eputs ("symbols: ");
@@ -743,6 +1407,7 @@ gc_dump_state ()
   gc_dump_register ("g_symbol_max", g_symbol_max);
   gc_dump_register ("g_macros", g_macros);
   gc_dump_register ("g_ports", g_ports);
+  gc_dump_register ("g_jit_constants", g_jit_constants);
   gc_dump_register ("cell_zero", cell_zero);
   gc_dump_register ("cell_nil", cell_nil);
 }
@@ -775,7 +1440,7 @@ gc_dump_arena (struct scm *cells, long size)
   dumps ("size="); dumps (ltoa (size)); dumpc ('\n');
   gc_dump_state ();
   gc_dump_stack ();
-  while (end->type == 0 && end->car == 0 && end->cdr == 0)
+  while (cell_type (end) == 0 && end->car == 0 && end->cdr == 0)
     {
       end = end - M2_CELL_SIZE;
       size = size - 1;
@@ -784,7 +1449,7 @@ gc_dump_arena (struct scm *cells, long size)
     {
       for (i=0; i < 16; i = i + 1)
         {
-          t = cells->type;
+          t = cell_type (cells);
           a = cells->car_value;
           d = cells->cdr_value;
           if (size == 0)
@@ -858,3 +1523,373 @@ gc_dump_arena (struct scm *cells, long size)
       dumpc ('\n');
     }
 }
+
+/* A heap image is written by dump-image right after a full collection:
+   IMAGE_HEADER cells holding the version, the layout and the roots,
+   the arena, every large object behind a cell with its old address and
+   size, and finally the stack.  Pointers are written as they are,
+   gc_load_image relocates them.  */
+#define IMAGE_MAGIC 1296385357
+// CONSTANT IMAGE_MAGIC 1296385357
+#define IMAGE_VERSION 1
+// CONSTANT IMAGE_VERSION 1
+#define IMAGE_HEADER 7
+// CONSTANT IMAGE_HEADER 7
+
+long gc_image_lo;
+long gc_image_hi;
+long gc_image_dist;
+long gc_image_numbers;
+long gc_image_chars;
+long gc_image_los_count;
+struct scm **gc_image_los_old;
+struct scm **gc_image_los_new;
+char const *gc_image_file_name;
+
+void
+gc_image_set (struct scm *header, long i, long type, long car, long cdr)
+{
+  struct scm *x = cell_ref (header, i);
+  set_cell_type (x, type);
+  x->car_value = car;
+  x->cdr_value = cdr;
+}
+
+void
+gc_image_write (int fd, void const *p, long n)
+{
+  char const *s = p;
+  long r;
+  while (n > 0)
+    {
+      r = write (fd, s, n);
+      if (r <= 0)
+        error (cell_symbol_system_error, make_string0 ("dump-image: write failed"));
+      s = s + r;
+      n = n - r;
+    }
+}
+
+/* Write the heap to FILE_NAME.  Return #f, or #t when the image is
+   resumed with MES_IMAGE.  */
+struct scm *
+dump_image (struct scm *file_name)
+{
+  if (gc_semispace != 0)
+    error (cell_symbol_system_error, make_string0 ("dump-image: not supported with MES_SEMISPACE"));
+#if MES_COMPACT_CELLS
+  error (cell_symbol_system_error, make_string0 ("dump-image: not supported with MES_COMPACT_CELLS"));
+#endif
+  int fd = mes_open (cell_bytes (file_name->string), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+  if (fd < 0)
+    error (cell_symbol_system_error, cons (make_string0 ("dump-image: cannot open"), file_name));
+  gc ();
+
+  long size = sizeof (struct scm);
+  long n = (g_free - g_cells) / M2_CELL_SIZE;
+  long los = 0;
+  struct scm *h;
+  for (h = gc_los; h != 0; h = h->car)
+    los = los + 1;
+  long depth = STACK_SIZE - g_stack;
+  long text = cast_voidp_to_long (&mes_builtins);
+  struct scm *header = malloc (IMAGE_HEADER * size);
+  gc_image_set (header, 0, IMAGE_MAGIC, IMAGE_VERSION, size);
+  gc_image_set (header, 1, text, cast_voidp_to_long (&vector_entry) - text, STACK_SIZE);
+  gc_image_set (header, 2, n, los, depth);
+  gc_image_set (header, 3, cast_scmp_to_long (g_cells), cast_scmp_to_long (gc_numbers),
+                cast_scmp_to_long (gc_chars));
+  gc_image_set (header, 4, cast_scmp_to_long (cell_nil), cast_scmp_to_long (g_symbols),
+                cast_scmp_to_long (g_symbol_max));
+  gc_image_set (header, 5, cast_scmp_to_long (g_macros), cast_scmp_to_long (g_ports),
+                cast_scmp_to_long (M0));
+  gc_image_set (header, 6, gc_count, cast_scmp_to_long (R0), 0);
+  gc_image_write (fd, header, IMAGE_HEADER * size);
+  gc_image_write (fd, g_cells, n * size);
+
+  struct scm *x;
+  for (h = gc_los; h != 0; h = h->car)
+    {
+      x = h + (2 * M2_CELL_SIZE);
+      n = cell_ref (h, 1)->value;
+      gc_image_set (header, 0, 0, cast_scmp_to_long (x), n);
+      gc_image_write (fd, header, size);
+      gc_image_write (fd, x, n * size);
+    }
+
+  long i;
+  for (i = g_stack; i < STACK_SIZE; i = i + 1)
+    {
+      gc_image_set (header, 0, 0, cast_scmp_to_long (g_stack_array[i]), 0);
+      gc_image_write (fd, header, size);
+    }
+  free (header);
+  return cell_f;
+}
+
+void
+gc_image_error (char const *msg, char const *file_name)
+{
+  eputs ("mes: ");
+  eputs (msg);
+  eputs (file_name);
+  eputs ("\n");
+  exit (1);
+}
+
+void
+gc_image_read (int fd, void *p, long n, char const *file_name)
+{
+  char *s = p;
+  long r;
+  while (n > 0)
+    {
+      r = read (fd, s, n);
+      if (r <= 0)
+        gc_image_error ("truncated image: ", file_name);
+      s = s + r;
+      n = n - r;
+    }
+}
+
+void
+gc_image_los_sift (long i, long n)     /*:((internal)) */
+{
+  struct scm *old = gc_image_los_old[i];
+  struct scm *new = gc_image_los_new[i];
+  long child = 2 * i + 1;
+  while (child < n)
+    {
+      if (child + 1 < n && gc_image_los_old[child + 1] > gc_image_los_old[child])
+        child = child + 1;
+      if (gc_image_los_old[child] <= old)
+        break;
+      gc_image_los_old[i] = gc_image_los_old[child];
+      gc_image_los_new[i] = gc_image_los_new[child];
+      i = child;
+      child = 2 * i + 1;
+    }
+  gc_image_los_old[i] = old;
+  gc_image_los_new[i] = new;
+}
+
+/* Heap sort the large objects by their old address, so that
+   gc_image_relocate can search them.  */
+void
+gc_image_los_sort ()                    /*:((internal)) */
+{
+  long n = gc_image_los_count;
+  long i;
+  for (i = n / 2 - 1; i >= 0; i = i - 1)
+    gc_image_los_sift (i, n);
+  struct scm *old;
+  struct scm *new;
+  for (i = n - 1; i > 0; i = i - 1)
+    {
+      old = gc_image_los_old[0];
+      new = gc_image_los_new[0];
+      gc_image_los_old[0] = gc_image_los_old[i];
+      gc_image_los_new[0] = gc_image_los_new[i];
+      gc_image_los_old[i] = old;
+      gc_image_los_new[i] = new;
+      gc_image_los_sift (0, i);
+    }
+}
+
+/* Return where the cell at old address P lives now.  A pointer that
+   is not into the old arena, the cached cells or a large object means
+   that the image is corrupt.  The end of the arena is a valid address
+   too, that is where an empty string or vector at its end points.  */
+long
+gc_image_relocate (long p)
+{
+  if (p >= gc_image_lo && p <= gc_image_hi)
+    return p - gc_image_dist;
+  long size = sizeof (struct scm);
+  if (p >= gc_image_numbers && p < gc_image_numbers + (CACHED_NUMBERS * size))
+    return cast_scmp_to_long (gc_numbers) + (p - gc_image_numbers);
+  if (p >= gc_image_chars && p < gc_image_chars + (CACHED_CHARS * size))
+    return cast_scmp_to_long (gc_chars) + (p - gc_image_chars);
+  long lo = 0;
+  long hi = gc_image_los_count;
+  long i;
+  long old;
+  struct scm *new;
+  struct scm *h;
+  while (lo < hi)
+    {
+      i = (lo + hi) / 2;
+      old = cast_scmp_to_long (gc_image_los_old[i]);
+      if (p < old)
+        hi = i;
+      else
+        {
+          new = gc_image_los_new[i];
+          h = new - M2_CELL_SIZE;
+          if (p < old + (h->value * size))
+            return cast_scmp_to_long (new) + (p - old);
+          lo = i + 1;
+        }
+    }
+  gc_image_error ("corrupt image: ", gc_image_file_name);
+  return p;
+}
+
+struct scm *
+gc_image_relocate_ (long p)
+{
+  return cast_charp_to_scmp (cast_long_to_charp (gc_image_relocate (p)));
+}
+
+void
+gc_image_relocate_cell (struct scm *x)
+{
+  long t = cell_type (x);
+  /* *INDENT-OFF* */
+  if (t == TMACRO
+      || t == TPAIR
+      || t == TREF
+      || t == TVARIABLE)
+    /* *INDENT-ON* */
+    x->car_value = gc_image_relocate (x->car_value);
+  /* *INDENT-OFF* */
+  if (t == TCLOSURE
+      || t == TCONTINUATION
+      || t == TKEYWORD
+      || t == TMACRO
+      || t == TPAIR
+      || t == TPORT
+      || t == TSPECIAL
+      || t == TSTRING
+      || t == TSTRUCT
+      || t == TSYMBOL
+      || t == TVALUES
+      || t == TVECTOR)
+    /* *INDENT-ON* */
+    x->cdr_value = gc_image_relocate (x->cdr_value);
+}
+
+/* Read the image FILE_NAME written by dump-image into the arena and
+   prepare the registers to resume it: dump-image returns #t.  The
+   builtins are moved along with the text of this executable, an image
+   only works with the mes that wrote it.  */
+void
+gc_load_image (char const *file_name)
+{
+  gc_image_file_name = file_name;
+#if MES_COMPACT_CELLS
+  gc_image_error ("image not supported with MES_COMPACT_CELLS: ", file_name);
+#endif
+  int fd = mes_open (file_name, O_RDONLY, 0);
+  if (fd < 0)
+    gc_image_error ("cannot open image: ", file_name);
+  long size = sizeof (struct scm);
+  struct scm *header = malloc (IMAGE_HEADER * size);
+  gc_image_read (fd, header, IMAGE_HEADER * size, file_name);
+  struct scm *x = cell_ref (header, 0);
+  if (cell_type (x) != IMAGE_MAGIC || x->car_value != IMAGE_VERSION || x->cdr_value != size)
+    gc_image_error ("not an image: ", file_name);
+  x = cell_ref (header, 1);
+  long text = cast_voidp_to_long (&mes_builtins);
+  if (x->car_value != cast_voidp_to_long (&vector_entry) - text)
+    gc_image_error ("image written by another mes: ", file_name);
+  long text_dist = text - cell_type (x);
+  if (x->cdr_value != STACK_SIZE)
+    gc_image_error ("image written with another MES_STACK: ", file_name);
+
+  x = cell_ref (header, 2);
+  long n = cell_type (x);
+  gc_image_los_count = x->car_value;
+  long depth = x->cdr_value;
+  gc_grow_arena (n, "gc_load_image: out of memory");
+  gc_image_read (fd, g_cells, n * size, file_name);
+  g_free = g_cells + (n * M2_CELL_SIZE);
+
+  x = cell_ref (header, 3);
+  gc_image_lo = cell_type (x);
+  gc_image_hi = gc_image_lo + (n * size);
+  gc_image_dist = gc_image_lo - cast_scmp_to_long (g_cells);
+  gc_image_numbers = x->car_value;
+  gc_image_chars = x->cdr_value;
+
+  gc_image_los_old = malloc ((gc_image_los_count + 1) * sizeof (struct scm *));
+  gc_image_los_new = malloc ((gc_image_los_count + 1) * sizeof (struct scm *));
+  long i;
+  for (i = 0; i < gc_image_los_count; i = i + 1)
+    {
+      gc_image_read (fd, header, size, file_name);
+      gc_image_los_old[i] = header->car;
+      gc_image_los_new[i] = gc_los_alloc (header->cdr_value);
+      gc_image_read (fd, gc_image_los_new[i], header->cdr_value * size, file_name);
+    }
+  gc_los_new = 0;
+  gc_los_young = gc_los;
+  gc_image_los_sort ();
+
+  struct scm *s;
+  for (s = g_cells; s < g_free; s = s + M2_CELL_SIZE)
+    {
+      gc_image_relocate_cell (s);
+      if (cell_type (s) == TBYTES)
+        s = s + ((bytes_cells (s->length) - 1) * M2_CELL_SIZE);
+    }
+  struct scm *end;
+  for (i = 0; i < gc_image_los_count; i = i + 1)
+    {
+      s = gc_image_los_new[i];
+      x = s - M2_CELL_SIZE;
+      end = s + (x->value * M2_CELL_SIZE);
+      while (s < end && cell_type (s) != TBYTES)
+        {
+          gc_image_relocate_cell (s);
+          s = s + M2_CELL_SIZE;
+        }
+    }
+
+  g_stack = STACK_SIZE - depth;
+  for (i = g_stack; i < STACK_SIZE; i = i + 1)
+    {
+      gc_image_read (fd, header, size, file_name);
+      g_stack_array[i] = gc_image_relocate_ (header->car_value);
+    }
+
+  x = cell_ref (header, 4);
+  cell_nil = gc_image_relocate_ (cell_type (x));
+  g_symbols = 0;
+  init_symbols_ ();
+  g_symbols = gc_image_relocate_ (x->car_value);
+  g_symbol_max = gc_image_relocate_ (x->cdr_value);
+  g_free = g_cells + (n * M2_CELL_SIZE);
+  x = cell_ref (header, 5);
+  g_macros = gc_image_relocate_ (cell_type (x));
+  g_ports = gc_image_relocate_ (x->car_value);
+  M0 = gc_image_relocate_ (x->cdr_value);
+  g_jit_constants = cell_nil;
+  x = cell_ref (header, 6);
+  /* Hash tables keyed by address must rehash.  */
+  gc_count = cell_type (x) + 1;
+  R0 = gc_image_relocate_ (x->car_value);
+
+  for (s = g_cells; s < g_free; s = s + M2_CELL_SIZE)
+    {
+      /* The <builtin> record type also passes builtin?.  */
+      if (cell_type (s) == TSTRUCT && s->length > 5 && builtin_p (s) == cell_t)
+        {
+          x = cell_ref (s->structure, 5);
+          x->value = x->value + text_dist;
+        }
+      /* The JIT state of a frame marker refers to code of the process
+         that wrote the image.  */
+      if (cell_type (s) == TLEXICAL && s->car_value < -1)
+        s->car_value = -1;
+      if (cell_type (s) == TBYTES)
+        s = s + ((bytes_cells (s->length) - 1) * M2_CELL_SIZE);
+    }
+
+  free (gc_image_los_old);
+  free (gc_image_los_new);
+  free (header);
+  R1 = cell_t;
+  R2 = cell_unspecified;
+  R3 = cell_vm_return;
+}
@@ -23,64 +23,167 @@
 
 #include <string.h>
 
+#define FNV_OFFSET_BASIS 2166136261U
+// CONSTANT FNV_OFFSET_BASIS 2166136261
+#define FNV_PRIME 16777619U
+// CONSTANT FNV_PRIME 16777619
+
+/* FNV-1a over the LENGTH bytes of S. */
+unsigned
+hash_bytes (char const *s, size_t length)
+{
+  unsigned hash = FNV_OFFSET_BASIS;
+  size_t i;
+  for (i = 0; i < length; i = i + 1)
+    {
+      hash = hash ^ ((0x100 + s[i]) % 0x100);
+      hash = hash * FNV_PRIME;
+    }
+  return hash;
+}
+
 int
-hash_cstring (char const *s, long size)
+hash_bytes_ (char const *s, size_t length, long size)
 {
-  int hash = s[0] * 37;
-  if (s[0] != 0)
-    if (s[1] != 0)
-      hash = hash + (s[1] * 43);
   assert_msg (size != 0, "size");
+  unsigned hash = hash_bytes (s, length);
   hash = hash % size;
   return hash;
 }
 
+/* Symbols are interned, their names are as good as their identity and
+   unlike their address they survive the garbage collector.  Other cells
+   are hashed by address, see hashq_rehash.  */
 int
 hashq_ (struct scm *x, long size)
 {
-  if (x->type == TSPECIAL || x->type == TSYMBOL)
-    return hash_cstring (cell_bytes (x->string), size);    /* FIXME: hash x directly. */
-  error (cell_symbol_system_error, cons (make_string0 ("hashq_: not a symbol"), x));
+  int t = cell_type (x);
+  if (t == TSPECIAL || t == TSYMBOL || t == TKEYWORD)
+    return hash_bytes_ (cell_bytes (x->string), x->length, size);
+  assert_msg (size != 0, "size");
+  unsigned hash;
+  if (t == TCHAR || t == TNUMBER)
+    hash = x->value;
+  else
+    hash = cast_voidp_to_long (x) / sizeof (struct scm);
+  hash = hash % size;
+  return hash;
+}
+
+int
+hashq_address_p (struct scm *x)
+{
+  int t = cell_type (x);
+  if (t == TSPECIAL || t == TSYMBOL || t == TKEYWORD || t == TCHAR || t == TNUMBER)
+    return 0;
+  return 1;
 }
 
 int
 hash_ (struct scm *x, long size)
 {
-  if (x->type != TSTRING)
+  if (cell_type (x) != TSTRING)
     {
       eputs ("hash_ failed, not a string:");
       display_error_ (x);
       assert_msg (0, "0");
     }
-  return hash_cstring (cell_bytes (x->string), size);
+  return hash_bytes_ (cell_bytes (x->string), x->length, size);
 }
 
 struct scm *
 hashq (struct scm *x, struct scm *size)
 {
-  eputs ("hashq not supporteed\n");
-  assert_msg (0, "0");
+  assert_number ("hashq", size);
+  return make_number (hashq_ (x, size->value));
 }
 
 struct scm *
 hash (struct scm *x, struct scm *size)
 {
-  eputs ("hash not supporteed\n");
-  assert_msg (0, "0");
+  assert_number ("hash", size);
+  return make_number (hash_ (x, size->value));
+}
+
+#define HASH_LOAD_FACTOR 2
+// CONSTANT HASH_LOAD_FACTOR 2
+
+/* Put all entries of TABLE in a new bucket vector of SIZE.  HASHQ_P
+   selects hashq_ or hash_ to find their new bucket.  */
+void
+hash_table_rehash_ (struct scm *table, long size, int hashq_p)
+{
+  struct scm *s = struct_ref_ (table, 3);
+  struct scm *buckets = struct_ref_ (table, 4);
+  struct scm *entries = cell_nil;
+  struct scm *bucket;
+  long i;
+  for (i = 0; i < s->value; i = i + 1)
+    {
+      bucket = vector_ref_ (buckets, i);
+      while (cell_type (bucket) == TPAIR)
+        {
+          entries = cons (bucket->car, entries);
+          bucket = bucket->cdr;
+        }
+    }
+  buckets = make_vector_ (size, cell_unspecified);
+  struct_set_x_ (table, 3, make_number (size));
+  struct_set_x_ (table, 4, buckets);
+  unsigned hash;
+  struct scm *e;
+  while (entries != cell_nil)
+    {
+      e = entries->car;
+      if (hashq_p != 0)
+        hash = hashq_ (e->car, size);
+      else
+        hash = hash_ (e->car, size);
+      bucket = vector_ref_ (buckets, hash);
+      if (cell_type (bucket) != TPAIR)
+        bucket = cell_nil;
+      vector_set_x_ (buckets, hash, cons (e, bucket));
+      entries = entries->cdr;
+    }
+}
+
+/* Once the garbage collector has run, keys that were hashed by address
+   may have moved: put all entries back in the right bucket.  */
+void
+hashq_rehash (struct scm *table)
+{
+  struct scm *epoch = struct_ref_ (table, 5);
+  if (epoch == cell_f || epoch->value == gc_count)
+    return;
+  struct scm *s = struct_ref_ (table, 3);
+  hash_table_rehash_ (table, s->value, 1);
+  struct_set_x_ (table, 5, make_number (gc_count));
+}
+
+/* Grow TABLE when it holds more than HASH_LOAD_FACTOR entries per
+   bucket, so that buckets stay short as the table fills up.  */
+void
+hash_table_grow (struct scm *table, int hashq_p)
+{
+  struct scm *s = struct_ref_ (table, 3);
+  struct scm *count = struct_ref_ (table, 6);
+  if (count->value > s->value * HASH_LOAD_FACTOR)
+    hash_table_rehash_ (table, (s->value * 4) + 1, hashq_p);
 }
 
 struct scm *
 hashq_get_handle (struct scm *table, struct scm *key, struct scm *dflt)
 {
+  hashq_rehash (table);
   struct scm *s = struct_ref_ (table, 3);
   long size = s->value;
   unsigned hash = hashq_ (key, size);
   struct scm *buckets = struct_ref_ (table, 4);
   struct scm *bucket = vector_ref_ (buckets, hash);
   struct scm *x = cell_f;
-  if (dflt->type == TPAIR)
+  if (cell_type (dflt) == TPAIR)
     x = dflt->car;
-  if (bucket->type == TPAIR)
+  if (cell_type (bucket) == TPAIR)
     x = assq (key, bucket);
   return x;
 }
@@ -103,9 +206,9 @@ hash_ref (struct scm *table, struct scm *key, struct scm *dflt)
   struct scm *buckets = struct_ref_ (table, 4);
   struct scm *bucket = vector_ref_ (buckets, hash);
   struct scm *x = cell_f;
-  if (dflt->type == TPAIR)
+  if (cell_type (dflt) == TPAIR)
     x = dflt->car;
-  if (bucket->type == TPAIR)
+  if (cell_type (bucket) == TPAIR)
     {
       x = assoc (key, bucket);
       if (x != cell_f)
@@ -114,25 +217,59 @@ hash_ref (struct scm *table, struct scm *key, struct scm *dflt)
   return x;
 }
 
+/* Look up the string key of LENGTH bytes at S in TABLE, without
+   allocating a string for it.  */
+struct scm *
+hash_ref_bytes (struct scm *table, char const *s, size_t length)
+{
+  struct scm *size = struct_ref_ (table, 3);
+  unsigned hash = hash_bytes_ (s, length, size->value);
+  struct scm *buckets = struct_ref_ (table, 4);
+  struct scm *bucket = vector_ref_ (buckets, hash);
+  struct scm *key;
+  while (cell_type (bucket) == TPAIR)
+    {
+      key = bucket->car->car;
+      if (key->length == length)
+        if (memcmp (cell_bytes (key->string), s, length) == 0)
+          return bucket->car->cdr;
+      bucket = bucket->cdr;
+    }
+  return cell_f;
+}
+
 struct scm *
 hash_set_x_ (struct scm *table, unsigned hash, struct scm *key, struct scm *value)
 {
   struct scm *buckets = struct_ref_ (table, 4);
   struct scm *bucket = vector_ref_ (buckets, hash);
-  if (bucket->type != TPAIR)
+  if (cell_type (bucket) != TPAIR)
     bucket = cell_nil;
   bucket = acons (key, value, bucket);
   vector_set_x_ (buckets, hash, bucket);
+  struct scm *count = struct_ref_ (table, 6);
+  struct_set_x_ (table, 6, make_number (count->value + 1));
   return value;
 }
 
 struct scm *
 hashq_set_x (struct scm *table, struct scm *key, struct scm *value)
 {
+  struct scm *x = hashq_get_handle (table, key, cell_f);
+  if (x != cell_f)
+    {
+      set_cdr_x (x, value);
+      return value;
+    }
   struct scm *s = struct_ref_ (table, 3);
   long size = s->value;
   unsigned hash = hashq_ (key, size);
-  return hash_set_x_ (table, hash, key, value);
+  if (hashq_address_p (key) != 0)
+    if (struct_ref_ (table, 5) == cell_f)
+      struct_set_x_ (table, 5, make_number (gc_count));
+  hash_set_x_ (table, hash, key, value);
+  hash_table_grow (table, 1);
+  return value;
 }
 
 struct scm *
@@ -141,20 +278,38 @@ hash_set_x (struct scm *table, struct scm *key, struct scm *value)
   struct scm *s = struct_ref_ (table, 3);
   long size = s->value;
   unsigned hash = hash_ (key, size);
-  return hash_set_x_ (table, hash, key, value);
+  struct scm *buckets = struct_ref_ (table, 4);
+  struct scm *bucket = vector_ref_ (buckets, hash);
+  struct scm *x = cell_f;
+  if (cell_type (bucket) == TPAIR)
+    x = assoc (key, bucket);
+  if (x != cell_f)
+    {
+      set_cdr_x (x, value);
+      return value;
+    }
+  hash_set_x_ (table, hash, key, value);
+  hash_table_grow (table, 0);
+  return value;
+}
+
+struct scm *
+hash_count (struct scm *table)
+{
+  return struct_ref_ (table, 6);
 }
 
 struct scm *
 hash_table_printer (struct scm *table)
 {
-  fdputs ("#<", __stdout);
+  port_puts ("#<", __stdout);
   display_ (struct_ref_ (table, 2));
-  fdputc (' ', __stdout);
-  fdputs ("size: ", __stdout);
+  port_putc (' ', __stdout);
+  port_puts ("size: ", __stdout);
   display_ (struct_ref_ (table, 3));
-  fdputc (' ', __stdout);
+  port_putc (' ', __stdout);
   struct scm *buckets = struct_ref_ (table, 4);
-  fdputs ("buckets: ", __stdout);
+  port_puts ("buckets: ", __stdout);
   int i;
   struct scm *e;
   for (i = 0; i < buckets->length; i = i + 1)
@@ -162,24 +317,26 @@ hash_table_printer (struct scm *table)
       e = vector_ref_ (buckets, i);
       if (e != cell_unspecified)
         {
-          fdputc ('[', __stdout);
-          while (e->type == TPAIR)
+          port_putc ('[', __stdout);
+          while (cell_type (e) == TPAIR)
             {
               write_ (e->car->car);
               e = e->cdr;
-              if (e->type == TPAIR)
-                fdputc (' ', __stdout);
+              if (cell_type (e) == TPAIR)
+                port_putc (' ', __stdout);
             }
-          fdputs ("]\n  ", __stdout);
+          port_puts ("]\n  ", __stdout);
         }
     }
-  fdputc ('>', __stdout);
+  port_putc ('>', __stdout);
 }
 
 struct scm *
 make_hashq_type ()              /*:((internal)) */
 {
   struct scm *fields = cell_nil;
+  fields = cons (cell_symbol_count, fields);
+  fields = cons (cell_symbol_epoch, fields);
   fields = cons (cell_symbol_buckets, fields);
   fields = cons (cell_symbol_size, fields);
   fields = cons (fields, cell_nil);
@@ -196,6 +353,8 @@ make_hash_table_ (long size)
 
   struct scm *buckets = make_vector_ (size, cell_unspecified);
   struct scm *values = cell_nil;
+  values = cons (make_number (0), values);
+  values = cons (cell_f, values);
   values = cons (buckets, values);
   values = cons (make_number (size), values);
   values = cons (cell_symbol_hashq_table, values);
@@ -208,10 +367,9 @@ struct scm *
 make_hash_table (struct scm *x)
 {
   long size = 0;
-  if (x->type == TPAIR)
-    {
-      assert_msg (x->type == TNUMBER, "x->type == TNUMBER");
-      size = x->value;
-    }
+  if (cell_type (x) == TPAIR)
+    x = x->car;
+  if (cell_type (x) == TNUMBER)
+    size = x->value;
   return make_hash_table_ (size);
 }
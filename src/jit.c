@@ -0,0 +1,915 @@
+/* -*-comment-start: "//";comment-end:""-*-
+ * GNU Mes --- Maxwell Equations of Software
+ * Copyright © 2026 agent <agent@local>
+ *
+ * This file is part of GNU Mes.
+ *
+ * GNU Mes is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * GNU Mes is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Mes.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mes/lib.h"
+#include "mes/mes.h"
+
+#if MES_HAVE_JIT
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* The baseline JIT, enabled with MES_JIT=1, translates the body of a
+   lambda into x86_64 code once apply has called it JIT_THRESHOLD
+   times.
+
+   Only a body that binds its formals in a vector frame is compiled,
+   see lexical_expand, and only if it is made of references to frames
+   and global variables, constants, if, and, or, cond, begin, calls of
+   the builtins that jit_builtin_p accepts, and calls in tail position.
+   The code for each form is a fixed template, and the templates are
+   stitched together into a function
+
+     struct scm *f (struct scm *slots, struct scm *a, struct scm *constants)
+
+   that gets the slots of its frame in rbx, its environment in r12 and
+   the slots of a vector of its constants in r13.  That vector is kept
+   in g_jit_constants.  The function returns the value of the body, or
+   cell_vm_apply after putting a tail call in R1, for apply to make.
+
+   The builtins never call back into eval_apply, so no collection runs
+   while the code holds cells.  They do not change any state either, so
+   the code may give up and return 0 at any point, for the interpreter
+   to evaluate the body instead; it does so when a builtin it calls is
+   no longer bound to its variable, or when the operator of a tail call
+   is a symbol, which apply resolves in the environment.
+
+   The state of a body is kept in its frame marker, whose depth is -1
+   when it is created: -1 - N after N calls, JIT_REJECTED when it cannot
+   be compiled, or JIT_REJECTED - 1 - I when it is compiled as function
+   I.  gc_load_image resets the markers, as code is not kept in
+   images.  */
+
+// CONSTANT JIT_THRESHOLD 100
+#define JIT_THRESHOLD 100
+// CONSTANT JIT_REJECTED -101
+#define JIT_REJECTED (-1 - JIT_THRESHOLD)
+// CONSTANT JIT_FUNCTION_SIZE 65536
+#define JIT_FUNCTION_SIZE 65536
+// CONSTANT JIT_PAGES_SIZE 1048576
+#define JIT_PAGES_SIZE 1048576
+
+#define JIT_CAR offsetof (struct scm, car)
+#define JIT_CDR offsetof (struct scm, cdr)
+
+typedef struct scm *(*jit_function) (struct scm *slots, struct scm *a, struct scm *constants);
+
+char *jit_code;
+long jit_pc;
+long jit_pushed;
+struct scm **jit_constants;
+long jit_constant_count;
+long jit_constant_max;
+long *jit_guards;
+long jit_guard_count;
+long jit_guard_max;
+
+char *jit_pages;
+long jit_pages_used;
+jit_function *jit_functions;
+long jit_function_count;
+long jit_function_max;
+
+void
+jit_init ()
+{
+  char *p = getenv ("MES_JIT");
+  if (p != 0)
+    if (p[0] != 0 && strcmp (p, "0") != 0)
+      g_jit = 1;
+}
+
+void
+jit_byte (long c)
+{
+  if (jit_pc < JIT_FUNCTION_SIZE)
+    jit_code[jit_pc] = c;
+  jit_pc = jit_pc + 1;
+}
+
+/* Emit the N bytes of OP, the first one first, as they read in a
+   disassembly.  */
+void
+jit_op (long n, long op)
+{
+  while (n != 0)
+    {
+      n = n - 1;
+      jit_byte (op >> (n * 8));
+    }
+}
+
+void
+jit_int (long x)
+{
+  long i;
+  for (i = 0; i < 4; i = i + 1)
+    {
+      jit_byte (x);
+      x = x >> 8;
+    }
+}
+
+void
+jit_long (long x)
+{
+  long i;
+  for (i = 0; i < 8; i = i + 1)
+    {
+      jit_byte (x);
+      x = x >> 8;
+    }
+}
+
+/* Emit a jump OP of N bytes with a 32-bit offset to patch, and return
+   the position of the offset.  */
+long
+jit_jump (long n, long op)
+{
+  jit_op (n, op);
+  jit_int (0);
+  return jit_pc - 4;
+}
+
+/* Make the jump whose offset is at AT go to the current position.  */
+void
+jit_patch (long at)
+{
+  long pc = jit_pc;
+  jit_pc = at;
+  jit_int (pc - (at + 4));
+  jit_pc = pc;
+}
+
+void
+jit_push ()
+{
+  jit_op (1, 0x50);             /* push rax */
+  jit_pushed = jit_pushed + 1;
+}
+
+/* Pop into the register with number R: 1 rcx, 2 rdx, 6 rsi, 7 rdi.  */
+void
+jit_pop (long r)
+{
+  jit_op (1, 0x58 + r);         /* pop r */
+  jit_pushed = jit_pushed - 1;
+}
+
+void
+jit_prologue ()
+{
+  jit_op (1, 0x55);             /* push rbp */
+  jit_op (3, 0x4889e5);         /* mov rbp, rsp */
+  jit_op (1, 0x53);             /* push rbx */
+  jit_op (2, 0x4154);           /* push r12 */
+  jit_op (2, 0x4155);           /* push r13 */
+  jit_op (2, 0x4156);           /* push r14 */
+  jit_op (3, 0x4889fb);         /* mov rbx, rdi */
+  jit_op (3, 0x4989f4);         /* mov r12, rsi */
+  jit_op (3, 0x4989d5);         /* mov r13, rdx */
+}
+
+void
+jit_epilogue ()
+{
+  jit_op (4, 0x488d65e0);       /* lea rsp, [rbp - 32] */
+  jit_op (2, 0x415e);           /* pop r14 */
+  jit_op (2, 0x415d);           /* pop r13 */
+  jit_op (2, 0x415c);           /* pop r12 */
+  jit_op (1, 0x5b);             /* pop rbx */
+  jit_op (1, 0x5d);             /* pop rbp */
+  jit_op (1, 0xc3);             /* ret */
+}
+
+void
+jit_bail ()
+{
+  jit_op (2, 0x31c0);           /* xor eax, eax */
+  jit_epilogue ();
+}
+
+/* Load the value of the global cell pointer at P.  */
+void
+jit_global (struct scm **p)
+{
+  jit_op (2, 0x48b9);           /* mov rcx, P */
+  jit_long (cast_voidp_to_long (p));
+  jit_op (3, 0x488b01);         /* mov rax, [rcx] */
+}
+
+/* Compare with #f.  */
+void
+jit_false_p ()
+{
+  jit_op (2, 0x48b9);           /* mov rcx, &cell_f */
+  jit_long (cast_voidp_to_long (&cell_f));
+  jit_op (3, 0x483b01);         /* cmp rax, [rcx] */
+}
+
+/* Compare the type of the cell in rax with T.  */
+void
+jit_type_p (long t)
+{
+  jit_op (3, 0x488338);         /* cmp qword [rax], T */
+  jit_byte (t);
+}
+
+void
+jit_call (void *f)
+{
+  int align_p = jit_pushed % 2;
+  if (align_p != 0)
+    jit_op (4, 0x4883ec08);     /* sub rsp, 8 */
+  jit_op (2, 0x48b8);           /* mov rax, F */
+  jit_long (cast_voidp_to_long (f));
+  jit_op (2, 0xffd0);           /* call rax */
+  if (align_p != 0)
+    jit_op (4, 0x4883c408);     /* add rsp, 8 */
+}
+
+long
+jit_constant (struct scm *x)
+{
+  long i;
+  for (i = 0; i < jit_constant_count; i = i + 1)
+    if (jit_constants[i] == x)
+      return i;
+  if (jit_constant_count == jit_constant_max)
+    {
+      jit_constant_max = jit_constant_max * 2 + 16;
+      jit_constants = realloc (jit_constants, jit_constant_max * sizeof (struct scm *));
+    }
+  jit_constants[i] = x;
+  jit_constant_count = jit_constant_count + 1;
+  return i;
+}
+
+void
+jit_load_constant (struct scm *x)
+{
+  long i = jit_constant (x);
+  jit_op (3, 0x498b85);         /* mov rax, [r13 + I] */
+  jit_int (i * sizeof (struct scm) + JIT_CAR);
+}
+
+/* Check at entry that the variable X still holds the builtin FN.  */
+void
+jit_guard (struct scm *x, struct scm *fn)
+{
+  long v = jit_constant (x->variable);
+  long f = jit_constant (fn);
+  long i;
+  for (i = 0; i < jit_guard_count; i = i + 2)
+    if (jit_guards[i] == v)
+      return;
+  if (jit_guard_count == jit_guard_max)
+    {
+      jit_guard_max = jit_guard_max * 2 + 16;
+      jit_guards = realloc (jit_guards, jit_guard_max * sizeof (long));
+    }
+  jit_guards[i] = v;
+  jit_guards[i + 1] = f;
+  jit_guard_count = jit_guard_count + 2;
+}
+
+/* The builtins that the code may call: those that neither evaluate nor
+   change anything.  */
+int
+jit_builtin_p (struct scm *fn)
+{
+  FUNCTION f = builtin_function (fn);
+  if (f == (FUNCTION) car
+      || f == (FUNCTION) cdr
+      || f == (FUNCTION) car_
+      || f == (FUNCTION) cdr_
+      || f == (FUNCTION) type_
+      || f == (FUNCTION) cons
+      || f == (FUNCTION) list
+      || f == (FUNCTION) eq_p
+      || f == (FUNCTION) equal2_p
+      || f == (FUNCTION) null_p
+      || f == (FUNCTION) pair_p
+      || f == (FUNCTION) length
+      || f == (FUNCTION) last_pair
+      || f == (FUNCTION) memq
+      || f == (FUNCTION) assq
+      || f == (FUNCTION) acons
+      || f == (FUNCTION) append2
+      || f == (FUNCTION) plus
+      || f == (FUNCTION) minus
+      || f == (FUNCTION) multiply
+      || f == (FUNCTION) modulo
+      || f == (FUNCTION) less_p
+      || f == (FUNCTION) greater_p
+      || f == (FUNCTION) is_p
+      || f == (FUNCTION) logand
+      || f == (FUNCTION) logior
+      || f == (FUNCTION) ash
+      || f == (FUNCTION) char_to_integer
+      || f == (FUNCTION) integer_to_char
+      || f == (FUNCTION) string_length
+      || f == (FUNCTION) string_ref
+      || f == (FUNCTION) string_equal_p
+      || f == (FUNCTION) symbol_to_string
+      || f == (FUNCTION) struct_ref
+      || f == (FUNCTION) vector_length
+      || f == (FUNCTION) vector_ref
+      || f == (FUNCTION) hashq_ref)
+    return 1;
+  return 0;
+}
+
+/* The builtins are called as apply would call them: an argument that
+   holds multiple values passes the first one.  */
+struct scm *
+jit_builtin1 (struct scm *fn, struct scm *x)
+{
+  if (cell_type (x) == TVALUES)
+    return apply_builtin (fn, cons (x, cell_nil));
+  return apply_builtin1 (fn, x);
+}
+
+struct scm *
+jit_builtin2 (struct scm *fn, struct scm *x, struct scm *y)
+{
+  if (cell_type (x) == TVALUES || cell_type (y) == TVALUES)
+    return apply_builtin (fn, cons (x, cons (y, cell_nil)));
+  return apply_builtin2 (fn, x, y);
+}
+
+struct scm *
+jit_builtin3 (struct scm *fn, struct scm *x, struct scm *y, struct scm *z)
+{
+  if (cell_type (x) == TVALUES || cell_type (y) == TVALUES)
+    return apply_builtin (fn, cons (x, cons (y, cons (z, cell_nil))));
+  return apply_builtin3 (fn, x, y, z);
+}
+
+struct scm *
+jit_builtin_list1 (struct scm *fn, struct scm *x)
+{
+  return apply_builtin (fn, cons (x, cell_nil));
+}
+
+struct scm *
+jit_builtin_list2 (struct scm *fn, struct scm *x, struct scm *y)
+{
+  return apply_builtin (fn, cons (x, cons (y, cell_nil)));
+}
+
+struct scm *
+jit_builtin_list3 (struct scm *fn, struct scm *x, struct scm *y, struct scm *z)
+{
+  return apply_builtin (fn, cons (x, cons (y, cons (z, cell_nil))));
+}
+
+/* Return the length of the list X, or -1 if it is not a proper list.  */
+long
+jit_length (struct scm *x)
+{
+  long n = 0;
+  while (cell_type (x) == TPAIR)
+    {
+      n = n + 1;
+      x = x->cdr;
+    }
+  if (x != cell_nil)
+    return -1;
+  return n;
+}
+
+int jit_expression (struct scm *x, int tail_p);
+
+int
+jit_lexical (struct scm *x)
+{
+  long depth = x->car_value;
+  long i = x->cdr_value * sizeof (struct scm) + JIT_CAR;
+  if (depth < 0)
+    return 0;
+  if (depth == 0)
+    {
+      jit_op (3, 0x488b83);     /* mov rax, [rbx + I] */
+      jit_int (i);
+      return 1;
+    }
+  jit_op (3, 0x4c89e0);         /* mov rax, r12 */
+  while (depth != 0)
+    {
+      jit_op (3, 0x488b40);     /* mov rax, [rax + cdr] */
+      jit_byte (JIT_CDR);
+      depth = depth - 1;
+    }
+  jit_op (3, 0x488b40);         /* mov rax, [rax + car]: (closure . FRAME) */
+  jit_byte (JIT_CAR);
+  jit_op (3, 0x488b40);         /* mov rax, [rax + cdr]: FRAME */
+  jit_byte (JIT_CDR);
+  jit_op (3, 0x488b40);         /* mov rax, [rax + vector] */
+  jit_byte (JIT_CDR);
+  jit_op (3, 0x488b80);         /* mov rax, [rax + I] */
+  jit_int (i);
+  return 1;
+}
+
+void
+jit_variable (struct scm *x)
+{
+  jit_load_constant (x->variable);
+  jit_op (3, 0x488b40);         /* mov rax, [rax + cdr] */
+  jit_byte (JIT_CDR);
+}
+
+/* Evaluate the list X of expressions, the last one in tail position if
+   TAIL_P.  */
+int
+jit_sequence (struct scm *x, int tail_p)
+{
+  if (jit_length (x) < 1)
+    return 0;
+  while (x->cdr != cell_nil)
+    {
+      if (jit_expression (x->car, 0) == 0)
+        return 0;
+      x = x->cdr;
+    }
+  return jit_expression (x->car, tail_p);
+}
+
+int
+jit_if (struct scm *x, int tail_p)
+{
+  long n = jit_length (x);
+  long at;
+  long end;
+  if (n != 2 && n != 3)
+    return 0;
+  if (jit_expression (x->car, 0) == 0)
+    return 0;
+  jit_false_p ();
+  at = jit_jump (2, 0x0f84);    /* je else */
+  if (jit_expression (x->cdr->car, tail_p) == 0)
+    return 0;
+  end = jit_jump (1, 0xe9);     /* jmp end */
+  jit_patch (at);
+  if (n == 3)
+    {
+      if (jit_expression (x->cdr->cdr->car, tail_p) == 0)
+        return 0;
+    }
+  else
+    jit_global (&cell_unspecified);
+  jit_patch (end);
+  return 1;
+}
+
+/* Evaluate the expressions of an and, if AND_P, or of an or.  */
+int
+jit_and_or (struct scm *x, int and_p, int tail_p)
+{
+  long at;
+  if (x->cdr == cell_nil)
+    return jit_expression (x->car, tail_p);
+  if (jit_expression (x->car, 0) == 0)
+    return 0;
+  jit_false_p ();
+  if (and_p != 0)
+    at = jit_jump (2, 0x0f84);  /* je end */
+  else
+    at = jit_jump (2, 0x0f85);  /* jne end */
+  if (jit_and_or (x->cdr, and_p, tail_p) == 0)
+    return 0;
+  jit_patch (at);
+  return 1;
+}
+
+int
+jit_cond (struct scm *clauses, int tail_p)
+{
+  struct scm *clause;
+  struct scm *body;
+  long at;
+  long end;
+  if (clauses == cell_nil)
+    {
+      jit_global (&cell_unspecified);
+      return 1;
+    }
+  clause = clauses->car;
+  if (cell_type (clause) != TPAIR)
+    return 0;
+  body = clause->cdr;
+  if (cell_type (body) == TPAIR)
+    if (body->car == cell_arrow)
+      return 0;
+  if (jit_expression (clause->car, 0) == 0)
+    return 0;
+  jit_false_p ();
+  at = jit_jump (2, 0x0f84);    /* je next */
+  if (body != cell_nil)
+    if (jit_sequence (body, tail_p) == 0)
+      return 0;
+  end = jit_jump (1, 0xe9);     /* jmp end */
+  jit_patch (at);
+  if (jit_cond (clauses->cdr, tail_p) == 0)
+    return 0;
+  jit_patch (end);
+  return 1;
+}
+
+/* Call the builtin FN, a fixed number of which are compared or added
+   inline when both are numbers.  */
+int
+jit_arithmetic (struct scm *fn, struct scm *args)
+{
+  FUNCTION f = builtin_function (fn);
+  long slow;
+  long slow2;
+  long end;
+  long end2;
+  if (jit_expression (args->car, 0) == 0)
+    return 0;
+  jit_push ();
+  if (jit_expression (args->cdr->car, 0) == 0)
+    return 0;
+  jit_pop (1);
+  jit_op (3, 0x488339);         /* cmp qword [rcx], TNUMBER */
+  jit_byte (TNUMBER);
+  slow = jit_jump (2, 0x0f85);  /* jne slow */
+  jit_type_p (TNUMBER);
+  slow2 = jit_jump (2, 0x0f85); /* jne slow */
+  jit_op (3, 0x488b51);         /* mov rdx, [rcx + value] */
+  jit_byte (JIT_CDR);
+  if (f == (FUNCTION) plus || f == (FUNCTION) minus)
+    {
+      if (f == (FUNCTION) plus)
+        jit_op (3, 0x480350);   /* add rdx, [rax + value] */
+      else
+        jit_op (3, 0x482b50);   /* sub rdx, [rax + value] */
+      jit_byte (JIT_CDR);
+      jit_op (3, 0x4889d7);     /* mov rdi, rdx */
+      jit_call (make_number);
+      end = jit_jump (1, 0xe9); /* jmp end */
+      end2 = end;
+    }
+  else
+    {
+      jit_op (3, 0x483b50);     /* cmp rdx, [rax + value] */
+      jit_byte (JIT_CDR);
+      jit_global (&cell_t);
+      if (f == (FUNCTION) less_p)
+        end = jit_jump (2, 0x0f8c);     /* jl end */
+      else if (f == (FUNCTION) greater_p)
+        end = jit_jump (2, 0x0f8f);     /* jg end */
+      else
+        end = jit_jump (2, 0x0f84);     /* je end */
+      jit_global (&cell_f);
+      end2 = jit_jump (1, 0xe9);        /* jmp end */
+    }
+  jit_patch (slow);
+  jit_patch (slow2);
+  jit_op (3, 0x4889ce);         /* mov rsi, rcx */
+  jit_op (3, 0x4889c2);         /* mov rdx, rax */
+  jit_op (3, 0x498bbd);         /* mov rdi, [r13 + FN] */
+  jit_int (jit_constant (fn) * sizeof (struct scm) + JIT_CAR);
+  jit_call (jit_builtin_list2);
+  jit_patch (end);
+  if (end2 != end)
+    jit_patch (end2);
+  return 1;
+}
+
+/* Call the builtin FN, the value of the variable X, with the N
+   expressions ARGS.  */
+int
+jit_builtin (struct scm *x, struct scm *fn, struct scm *args, long n)
+{
+  FUNCTION f = builtin_function (fn);
+  long arity = builtin_arity_ (fn);
+  struct scm *y;
+  if (arity != n && arity != -1)
+    return 0;
+  if (n < 1 || n > 3)
+    return 0;
+  jit_guard (x, fn);
+  if (n == 2)
+    if (f == (FUNCTION) plus
+        || f == (FUNCTION) minus
+        || f == (FUNCTION) less_p
+        || f == (FUNCTION) greater_p
+        || f == (FUNCTION) is_p)
+      return jit_arithmetic (fn, args);
+  for (y = args; y->cdr != cell_nil; y = y->cdr)
+    {
+      if (jit_expression (y->car, 0) == 0)
+        return 0;
+      jit_push ();
+    }
+  if (jit_expression (y->car, 0) == 0)
+    return 0;
+  if (n == 1)
+    jit_op (3, 0x4889c6);       /* mov rsi, rax */
+  else if (n == 2)
+    {
+      jit_op (3, 0x4889c2);     /* mov rdx, rax */
+      jit_pop (6);
+    }
+  else
+    {
+      jit_op (3, 0x4889c1);     /* mov rcx, rax */
+      jit_pop (2);
+      jit_pop (6);
+    }
+  jit_op (3, 0x498bbd);         /* mov rdi, [r13 + FN] */
+  jit_int (jit_constant (fn) * sizeof (struct scm) + JIT_CAR);
+  if (arity == -1)
+    {
+      if (n == 1)
+        jit_call (jit_builtin_list1);
+      else if (n == 2)
+        jit_call (jit_builtin_list2);
+      else
+        jit_call (jit_builtin_list3);
+    }
+  else if (n == 1)
+    jit_call (jit_builtin1);
+  else if (n == 2)
+    jit_call (jit_builtin2);
+  else
+    jit_call (jit_builtin3);
+  return 1;
+}
+
+/* Return (F . ARGS) in R1 for apply.  */
+int
+jit_tail_call (struct scm *f, struct scm *args, long n)
+{
+  long at;
+  long i;
+  if (jit_expression (f, 0) == 0)
+    return 0;
+  jit_type_p (TSYMBOL);
+  at = jit_jump (2, 0x0f85);    /* jne call */
+  jit_bail ();
+  jit_patch (at);
+  jit_push ();
+  while (args != cell_nil)
+    {
+      if (jit_expression (args->car, 0) == 0)
+        return 0;
+      jit_push ();
+      args = args->cdr;
+    }
+  jit_global (&cell_nil);
+  for (i = 0; i <= n; i = i + 1)
+    {
+      jit_pop (7);
+      jit_op (3, 0x4889c6);     /* mov rsi, rax */
+      jit_call (cons);
+    }
+  jit_op (2, 0x48b9);           /* mov rcx, &R1 */
+  jit_long (cast_voidp_to_long (&R1));
+  jit_op (3, 0x488901);         /* mov [rcx], rax */
+  jit_global (&cell_vm_apply);
+  jit_epilogue ();
+  return 1;
+}
+
+/* Compile a call of a builtin that jit_builtin_p accepts in any
+   position, and any other call in tail position, for apply to make.  */
+int
+jit_application (struct scm *x, int tail_p)
+{
+  struct scm *f = x->car;
+  struct scm *v;
+  long n = jit_length (x->cdr);
+  int t = cell_type (f);
+  if (n < 0)
+    return 0;
+  if (t == TVARIABLE)
+    {
+      v = f->variable->cdr;
+      if (builtin_p (v) == cell_t)
+        if (jit_builtin_p (v) != 0)
+          return jit_builtin (f, v, x->cdr, n);
+    }
+  if (tail_p == 0)
+    return 0;
+  if (t != TVARIABLE && t != TLEXICAL)
+    return 0;
+  return jit_tail_call (f, x->cdr, n);
+}
+
+int
+jit_expression (struct scm *x, int tail_p)
+{
+  int t = cell_type (x);
+  struct scm *c;
+  if (t == TLEXICAL)
+    return jit_lexical (x);
+  if (t == TVARIABLE)
+    {
+      jit_variable (x);
+      return 1;
+    }
+  if (t == TSYMBOL || t == TBROKEN_HEART)
+    return 0;
+  if (t != TPAIR)
+    {
+      jit_load_constant (x);
+      return 1;
+    }
+  c = x->car;
+  if (c == cell_symbol_quote)
+    {
+      if (jit_length (x) != 2)
+        return 0;
+      jit_load_constant (x->cdr->car);
+      return 1;
+    }
+  if (c == cell_symbol_if)
+    return jit_if (x->cdr, tail_p);
+  if (c == cell_symbol_and || c == cell_symbol_or)
+    {
+      if (x->cdr == cell_nil)
+        {
+          if (c == cell_symbol_and)
+            jit_global (&cell_t);
+          else
+            jit_global (&cell_f);
+          return 1;
+        }
+      if (jit_length (x->cdr) < 0)
+        return 0;
+      return jit_and_or (x->cdr, c == cell_symbol_and, tail_p);
+    }
+  if (c == cell_symbol_cond)
+    {
+      if (jit_length (x->cdr) < 0)
+        return 0;
+      return jit_cond (x->cdr, tail_p);
+    }
+  if (c == cell_symbol_begin)
+    return jit_sequence (x->cdr, tail_p);
+  if (cell_type (c) == TSYMBOL)
+    return 0;
+  return jit_application (x, tail_p);
+}
+
+/* Copy the SIZE bytes of code at CODE to executable pages, and return
+   their address, or 0.  */
+char *
+jit_install (char const *code, long size)
+{
+  char *p;
+  if (jit_pages == 0 || jit_pages_used + size > JIT_PAGES_SIZE)
+    {
+      p = mmap (0, JIT_PAGES_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+        return 0;
+      jit_pages = p;
+      jit_pages_used = 0;
+    }
+  if (mprotect (jit_pages, JIT_PAGES_SIZE, PROT_READ | PROT_WRITE) != 0)
+    return 0;
+  p = jit_pages + jit_pages_used;
+  memcpy (p, code, size);
+  mprotect (jit_pages, JIT_PAGES_SIZE, PROT_READ | PROT_EXEC);
+  /* Keep functions 16-byte aligned.  */
+  jit_pages_used = jit_pages_used + ((size + 15) / 16) * 16;
+  return p;
+}
+
+/* Compile BODY, which starts with its frame marker, and return the new
+   state of the marker.  */
+long
+jit_compile (struct scm *body)
+{
+  struct scm *constants;
+  struct scm *v;
+  struct scm *x;
+  char *p;
+  long entry;
+  long head;
+  long i;
+  long at;
+  long size;
+  if (jit_code == 0)
+    jit_code = malloc (JIT_FUNCTION_SIZE);
+  jit_pc = 0;
+  jit_pushed = 0;
+  jit_constant_count = 0;
+  jit_guard_count = 0;
+
+  if (body->cdr == cell_nil)
+    jit_global (&cell_unspecified);
+  else if (jit_sequence (body->cdr, 1) == 0)
+    return JIT_REJECTED;
+  jit_epilogue ();
+
+  /* The head of the function, with a stub to give up, the entry and
+     the guards, is emitted after the body and goes in front of it.  */
+  head = jit_pc;
+  jit_bail ();
+  entry = jit_pc - head;
+  jit_prologue ();
+  for (i = 0; i < jit_guard_count; i = i + 2)
+    {
+      jit_op (3, 0x498b85);     /* mov rax, [r13 + VARIABLE] */
+      jit_int (jit_guards[i] * sizeof (struct scm) + JIT_CAR);
+      jit_op (3, 0x488b40);     /* mov rax, [rax + cdr] */
+      jit_byte (JIT_CDR);
+      jit_op (3, 0x493b85);     /* cmp rax, [r13 + BUILTIN] */
+      jit_int (jit_guards[i + 1] * sizeof (struct scm) + JIT_CAR);
+      at = jit_jump (2, 0x0f85);        /* jne bail */
+      size = jit_pc;
+      jit_pc = at;
+      jit_int (head - (at + 4));
+      jit_pc = size;
+    }
+  size = jit_pc;
+  if (size > JIT_FUNCTION_SIZE - head)
+    return JIT_REJECTED;
+
+  memmove (jit_code + size, jit_code, head);
+  p = jit_install (jit_code + head, size);
+  if (p == 0)
+    return JIT_REJECTED;
+
+  constants = alloc (1);
+  v = alloc (jit_constant_count);
+  set_cell_type (constants, TVECTOR);
+  constants->length = jit_constant_count;
+  constants->vector = v;
+  for (i = 0; i < jit_constant_count; i = i + 1)
+    {
+      x = cell_ref (v, i);
+      set_cell_type (x, TREF);
+      x->ref = jit_constants[i];
+      x->cdr = 0;
+    }
+
+  i = jit_function_count;
+  if (i == jit_function_max)
+    {
+      jit_function_max = jit_function_max * 2 + 16;
+      jit_functions = realloc (jit_functions, jit_function_max * sizeof (jit_function));
+      x = g_jit_constants;
+      g_jit_constants = make_vector_ (jit_function_max, cell_f);
+      for (at = 0; at < i; at = at + 1)
+        vector_set_x_ (g_jit_constants, at, vector_ref_ (x, at));
+    }
+  vector_set_x_ (g_jit_constants, i, constants);
+  jit_functions[i] = (jit_function) (p + entry);
+  jit_function_count = i + 1;
+  return JIT_REJECTED - 1 - i;
+}
+
+/* Count a call of the body in R1 in the environment R0, compiling it
+   once it is called often enough, and run it if it is compiled.
+   Return its value, cell_vm_apply with a call in R1 to make, or 0 to
+   evaluate it.  */
+struct scm *
+jit_apply ()
+{
+  struct scm *marker = R1->car;
+  struct scm *constants;
+  struct scm *frame;
+  long state = marker->car_value;
+  long i;
+  if (state > JIT_REJECTED)
+    {
+      state = state - 1;
+      if (state == JIT_REJECTED)
+        state = jit_compile (R1);
+      marker->car_value = state;
+    }
+  if (state >= JIT_REJECTED)
+    return 0;
+  i = JIT_REJECTED - 1 - state;
+  gc_check ();
+  constants = cell_ref (g_jit_constants->vector, i)->ref;
+  frame = R0->car->cdr;
+  return jit_functions[i] (frame->vector, R0, constants->vector);
+}
+
+#endif /* MES_HAVE_JIT */
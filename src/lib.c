@@ -32,14 +32,14 @@
 struct scm *
 type_ (struct scm *x)
 {
-  return make_number (x->type);
+  return make_number (cell_type (x));
 }
 
 struct scm *
 car_ (struct scm *x)
 {
   struct scm *a = x->car;
-  if (x->type == TPAIR)
+  if (cell_type (x) == TPAIR)
     return a;
   return make_number (cast_scmp_to_long (a));
 }
@@ -48,7 +48,7 @@ struct scm *
 cdr_ (struct scm *x)
 {
   struct scm *d = x->cdr;
-  if (x->type == TPAIR || x->type == TCLOSURE)
+  if (cell_type (x) == TPAIR || cell_type (x) == TCLOSURE)
     return d;
   return make_number (cast_scmp_to_long (d));
 }
@@ -68,7 +68,7 @@ xassq (struct scm *x, struct scm *a)            /* For speed in core. */
 struct scm *
 memq (struct scm *x, struct scm *a)
 {
-  int t = x->type;
+  int t = cell_type (x);
   if (t == TCHAR || t == TNUMBER)
     {
       long v = x->value;
@@ -84,7 +84,7 @@ memq (struct scm *x, struct scm *a)
     {
       while (a != cell_nil)
         {
-          if (a->car->type == TKEYWORD)
+          if (cell_type (a->car) == TKEYWORD)
             if (string_equal_p (x, a->car) == cell_t)
               return a;
           a = a->cdr;
@@ -110,7 +110,7 @@ equal2_p (struct scm *a, struct scm *b)
 equal2:
   if (a == b)
     return cell_t;
-  if (a->type == TPAIR && b->type == TPAIR)
+  if (cell_type (a) == TPAIR && cell_type (b) == TPAIR)
     {
       if (equal2_p (a->car, b->car) == cell_t)
         {
@@ -120,9 +120,9 @@ equal2:
         }
       return cell_f;
     }
-  if (a->type == TSTRING && b->type == TSTRING)
+  if (cell_type (a) == TSTRING && cell_type (b) == TSTRING)
     return string_equal_p (a, b);
-  if (a->type == TVECTOR && b->type == TVECTOR)
+  if (cell_type (a) == TVECTOR && cell_type (b) == TVECTOR)
     {
       if (a->length != b->length)
         return cell_f;
@@ -130,9 +130,9 @@ equal2:
         {
           ai = cell_ref (a->vector, i);
           bi = cell_ref (b->vector, i);
-          if (ai->type == TREF)
+          if (cell_type (ai) == TREF)
             ai = ai->ref;
-          if (bi->type == TREF)
+          if (cell_type (bi) == TREF)
             bi = bi->ref;
           if (equal2_p (ai, bi) == cell_f)
             return cell_f;
@@ -157,7 +157,7 @@ last_pair (struct scm *x)
 struct scm *
 pair_p (struct scm *x)
 {
-  if (x->type == TPAIR)
+  if (cell_type (x) == TPAIR)
     return cell_t;
   return cell_f;
 }
@@ -54,6 +54,8 @@ apply_builtin3 (struct scm *fn, struct scm *x, struct scm *y, struct scm *z)
 #undef cast_voidp_to_charp
 #undef cast_scmp_to_long
 #undef cast_scmp_to_charp
+#undef cell_type
+#undef set_cell_type
 
 struct scm *
 cast_charp_to_scmp (char const *i)
@@ -84,3 +86,15 @@ cast_scmp_to_charp (struct scm *i)
 {
   return i;
 }
+
+long
+cell_type (struct scm *x)
+{
+  return x->type;
+}
+
+void
+set_cell_type (struct scm *x, long type)
+{
+  x->type = type;
+}
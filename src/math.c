@@ -30,7 +30,7 @@
 void
 assert_number (char const *name, struct scm *x)
 {
-  if (x->type != TNUMBER)
+  if (cell_type (x) != TNUMBER)
     {
       eputs (name);
       error (cell_symbol_not_a_number, x);
@@ -39,6 +39,16 @@ mes_g_stack (struct scm *a)             /*:((internal)) */
   return R0;
 }
 
+struct scm *
+mes_argv (int argc, char **argv)
+{
+  struct scm *lst = cell_nil;
+  int i;
+  for (i = argc - 1; i >= 0; i = i - 1)
+    lst = cons (make_string0 (argv[i]), lst);
+  return lst;
+}
+
 struct scm *
 mes_environment (int argc, char **argv)
 {
@@ -65,11 +75,7 @@ mes_environment (int argc, char **argv)
   a = acons (cell_symbol_arch, make_string0 (arch), a);
 
 #if !MES_MINI
-  struct scm *lst = cell_nil;
-  int i;
-  for (i = argc - 1; i >= 0; i = i - 1)
-    lst = cons (make_string0 (argv[i]), lst);
-  a = acons (cell_symbol_argv, lst, a);
+  a = acons (cell_symbol_argv, mes_argv (argc, argv), a);
 #endif
 
   return mes_g_stack (a);
@@ -177,15 +183,18 @@ init (char **envp)
   if (p != 0)
     g_debug = atoi (p);
   g_mini = cast_charp_to_long (getenv ("MES_MINI"));
-  open_boot ();
+  cache_init ();
+#if MES_HAVE_JIT
+  jit_init ();
+#endif
+  if (getenv ("MES_IMAGE") == 0)
+    open_boot ();
   gc_init ();
 }
 
-int
-main (int argc, char **argv, char **envp)
+void
+mes_boot (int argc, char **argv)
 {
-  init (envp);
-
   struct scm *a = mes_environment (argc, argv);
   a = mes_builtins (a);
   a = init_time (a);
@@ -208,6 +217,22 @@ main (int argc, char **argv, char **envp)
       eputs ("\n");
     }
   R3 = cell_vm_begin_expand;
+}
+
+int
+main (int argc, char **argv, char **envp)
+{
+  init (envp);
+
+  char *image = getenv ("MES_IMAGE");
+  if (image != 0)
+    {
+      gc_load_image (image);
+      module_define_x (M0, cell_symbol_argv, mes_argv (argc, argv));
+    }
+  else
+    mes_boot (argc, argv);
+
   R1 = eval_apply ();
   if (g_debug != 0)
     {
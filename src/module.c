@@ -56,7 +56,7 @@ make_initial_module (struct scm *a)     /*:((internal)) */
   R0 = cons (a->cdr->car, R0);
   R0 = cons (a->car, R0);
   M0 = module;
-  while (a->type == TPAIR)
+  while (cell_type (a) == TPAIR)
     {
       module_define_x (module, a->car->car, a->car->cdr);
       a = a->cdr;
@@ -68,19 +68,19 @@ make_initial_module (struct scm *a)     /*:((internal)) */
 struct scm *
 module_printer (struct scm *module)
 {
-  fdputs ("#<", __stdout);
+  port_puts ("#<", __stdout);
   display_ (struct_ref_ (module, 2));
-  fdputc (' ', __stdout);
-  fdputs ("name: ", __stdout);
+  port_putc (' ', __stdout);
+  port_puts ("name: ", __stdout);
   display_ (struct_ref_ (module, 3));
-  fdputc (' ', __stdout);
-  fdputs ("locals: ", __stdout);
+  port_putc (' ', __stdout);
+  port_puts ("locals: ", __stdout);
   display_ (struct_ref_ (module, 4));
-  fdputc (' ', __stdout);
+  port_putc (' ', __stdout);
   struct scm *table = struct_ref_ (module, 5);
-  fdputs ("globals:\n  ", __stdout);
+  port_puts ("globals:\n  ", __stdout);
   display_ (table);
-  fdputc ('>', __stdout);
+  port_putc ('>', __stdout);
 }
 
 struct scm *
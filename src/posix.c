@@ -35,6 +35,7 @@
 #include <unistd.h>
 
 #if SYSTEM_LIBC
+#include <sys/mman.h>
 #define __raise(x) -1
 #endif
 
@@ -55,10 +56,38 @@ abort_ ()                   /*:((name . "abort")) */
 struct scm *
 exit_ (struct scm *x)                   /*:((name . "exit")) */
 {
-  assert_msg (x->type == TNUMBER, "x->type == TNUMBER");
+  assert_msg (cell_type (x) == TNUMBER, "cell_type (x) == TNUMBER");
   exit (x->value);
 }
 
+/* An input port that reads from memory, a string port or a mapped
+   file, holds (DATA . CURSOR).  DATA is a string or, for a mapped file,
+   a number cell with the length and the address of the mapping.  */
+char *
+port_bytes (struct scm *data)
+{
+  if (cell_type (data) == TNUMBER)
+    return cast_long_to_charp (data->value);
+  return cell_bytes (data->string);
+}
+
+/* Unmap the file that PORT reads, once it is read or closed; PORT then
+   reads an empty string.  */
+void
+port_unmap (struct scm *port)   /*:((internal)) */
+{
+  struct scm *data = port->cdr->car;
+  struct scm *cursor = port->cdr->cdr;
+  if (cell_type (data) != TNUMBER)
+    return;
+#if SYSTEM_LIBC
+  munmap (port_bytes (data), data->length);
+#endif
+  port->cdr->car = make_string0 ("");
+  gc_write_barrier (port->cdr);
+  cursor->value = 0;
+}
+
 int
 peekchar ()
 {
@@ -68,13 +97,16 @@ peekchar ()
       unreadchar (c);
       return c;
     }
-  struct scm *port = current_input_port ();
-  struct scm *string = port->string;
-  size_t length = string->length;
-  if (length == 0)
-    return -1;
-  char const *p = cell_bytes (string->string);
-  return p[0];
+  struct scm *port = g_ports->car;
+  struct scm *data = port->cdr->car;
+  struct scm *cursor = port->cdr->cdr;
+  if (cursor->value == data->length)
+    {
+      port_unmap (port);
+      return -1;
+    }
+  char const *p = port_bytes (data);
+  return (0x100 + p[cursor->value]) % 0x100;
 }
 
 int
@@ -82,15 +114,17 @@ readchar ()
 {
   if (__stdin >= 0)
     return fdgetc (__stdin);
-  struct scm *port = current_input_port ();
-  struct scm *string = port->string;
-  size_t length = string->length;
-  if (length == 0)
-    return -1;
-  char const *p = cell_bytes (string->string);
-  int c = p[0];
-  p = p + 1;
-  port->string = make_string (p, length - 1);
+  struct scm *port = g_ports->car;
+  struct scm *data = port->cdr->car;
+  struct scm *cursor = port->cdr->cdr;
+  if (cursor->value == data->length)
+    {
+      port_unmap (port);
+      return -1;
+    }
+  char const *p = port_bytes (data);
+  int c = (0x100 + p[cursor->value]) % 0x100;
+  cursor->value = cursor->value + 1;
   return c;
 }
 
@@ -101,15 +135,27 @@ unreadchar (int c)
     return fdungetc (c, __stdin);
   if (c == EOF) /* can't unread EOF */
     return c;
-  struct scm *port = current_input_port ();
-  struct scm *string = port->string;
-  size_t length = string->length;
-  char *p = cell_bytes (string->string);
-  p = p - 1;
-  string = make_string (p, length + 1);
-  p = cell_bytes (string->string);
-  p[0] = c;
-  port->string = string;
+  struct scm *port = g_ports->car;
+  struct scm *data = port->cdr->car;
+  struct scm *cursor = port->cdr->cdr;
+  size_t length = data->length;
+  size_t i = cursor->value;
+  char *p = port_bytes (data);
+  if (i > 0 && (0x100 + p[i - 1]) % 0x100 == c)
+    {
+      cursor->value = i - 1;
+      return c;
+    }
+  /* Unreading a character that was not read needs a new buffer.  */
+  length = length - i;
+  if (length + 1 > MAX_STRING)
+    assert_max_string (length + 1, "unreadchar", p + i);
+  g_buf[0] = c;
+  memcpy (g_buf + 1, p + i, length);
+  g_buf[length + 1] = 0;
+  port->cdr->car = make_string (g_buf, length + 1);
+  gc_write_barrier (port->cdr);
+  cursor->value = 0;
   return c;
 }
 
@@ -141,12 +187,12 @@ peek_char ()
 struct scm *
 read_char (struct scm *port)            /*:((arity . n)) */
 {
-  int fd = __stdin;
-  if (port->type == TPAIR)
-    if (port->car->type == TNUMBER)
-      __stdin = port->car->value;
+  struct scm *prev = cell_f;
+  if (cell_type (port) == TPAIR)
+    prev = set_current_input_port (port->car);
   struct scm *c = make_char (readchar ());
-  __stdin = fd;
+  if (prev != cell_f)
+    set_current_input_port (prev);
   return c;
 }
 
@@ -170,10 +216,10 @@ write_byte (struct scm *x)              /*:((arity . n)) */
   struct scm *c = car (x);
   struct scm *p = cdr (x);
   int fd = __stdout;
-  if (p->type == TPAIR)
+  if (cell_type (p) == TPAIR)
     {
       struct scm *f = p->car;
-      if (f->type == TNUMBER)
+      if (cell_type (f) == TNUMBER)
         {
           long v = f->value;
           if (v != 1)
@@ -181,11 +227,13 @@ write_byte (struct scm *x)              /*:((arity . n)) */
           if (v == 2)
             fd = __stderr;
         }
+      else if (cell_type (f) == TPORT)
+        fd = port_argument (f);
     }
   char cc = c->value;
-  write (fd, &cc, 1);
+  port_write (&cc, 1, fd);
 #if !__MESC__
-  assert_msg (c->type == TNUMBER || c->type == TCHAR, "c->type == TNUMBER || c->type == TCHAR");
+  assert_msg (cell_type (c) == TNUMBER || cell_type (c) == TCHAR, "cell_type (c) == TNUMBER || cell_type (c) == TCHAR");
 #endif
   return c;
 }
@@ -218,60 +266,189 @@ access_p (struct scm *file_name, struct scm *mode)
   return cell_f;
 }
 
+/* A port that reads or writes memory is referred to by a negative
+   number, like a file descriptor.  Only the current input port, the
+   current output port and the output port that was last passed as an
+   argument can be referred to; they are kept in G_PORTS.  */
 struct scm *
-current_input_port ()
+port_ref (long port)                    /*:((internal)) */
 {
-  if (__stdin >= 0)
-    return make_number (__stdin);
   struct scm *x = g_ports;
   struct scm *a;
-  while (x != 0)
+  while (x != cell_nil)
     {
       a = x->car;
-      if (a->port == __stdin)
-        return a;
+      if (cell_type (a) == TPORT)
+        if (a->port == port)
+          return a;
       x = x->cdr;
     }
-  return x->car;
+  error (cell_symbol_system_error, cons (make_string0 ("no such port"), make_number (port)));
+  return cell_f;
+}
+
+void
+port_set (struct scm *x, struct scm *port)      /*:((internal)) */
+{
+  x->car = port;
+  gc_write_barrier (x);
+}
+
+/* Return the number of PORT, an argument, and keep PORT so that it can
+   be referred to by that number.  */
+int
+port_argument (struct scm *port)
+{
+  port_set (g_ports->cdr->cdr, port);
+  return port->port;
+}
+
+/* Write to FD, or to the string output port numbered FD when FD is
+   negative.  */
+int
+port_write (char const *s, int length, int fd)
+{
+  if (fd >= 0)
+    return write (fd, s, length);
+  struct scm *port = port_ref (fd);
+  struct scm *buffer = port->cdr->car;
+  struct scm *count = port->cdr->cdr;
+  long n = count->value + length;
+  char *p;
+  if (n >= buffer->length)
+    {
+      long size = buffer->length * 2;
+      if (size <= n)
+        size = n + 1;
+      p = cell_bytes (buffer);
+      buffer = make_bytes (0, size);
+      memcpy (cell_bytes (buffer), p, count->value);
+      port->cdr->car = buffer;
+      gc_write_barrier (port->cdr);
+    }
+  p = cell_bytes (buffer);
+  memcpy (p + count->value, s, length);
+  p[n] = 0;
+  count->value = n;
+  return length;
+}
+
+int
+port_putc (int c, int fd)
+{
+  char cc = c;
+  port_write (&cc, 1, fd);
+  return 0;
+}
+
+int
+port_puts (char const *s, int fd)
+{
+  port_write (s, strlen (s), fd);
+  return 0;
+}
+
+struct scm *
+current_input_port ()
+{
+  if (__stdin >= 0)
+    return make_number (__stdin);
+  return g_ports->car;
 }
 
+#if SYSTEM_LIBC
+/* Map FILEDES, a regular file, read-only and return a port that reads
+   it, or 0 when it cannot be mapped, such as a pipe, a tty or an empty
+   file.  */
+struct scm *
+open_input_mapped (int filedes) /*:((internal)) */
+{
+  struct stat st;
+  if (fstat (filedes, &st) != 0)
+    return 0;
+  if (S_ISREG (st.st_mode) == 0 || st.st_size == 0)
+    return 0;
+  void *p = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, filedes, 0);
+  if (p == MAP_FAILED)
+    return 0;
+  close (filedes);
+  struct scm *data = make_value_cell (TNUMBER, st.st_size, cast_voidp_to_long (p));
+  return make_string_port (data);
+}
+#endif
+
 struct scm *
 open_input_file (struct scm *file_name)
 {
   int filedes = mes_open (cell_bytes (file_name->string), O_RDONLY, 0);
   if (filedes == -1)
     error (cell_symbol_system_error, cons (make_string0 ("No such file or directory"), file_name));
+#if SYSTEM_LIBC
+  struct scm *port = open_input_mapped (filedes);
+  if (port != 0)
+    return port;
+#endif
   return make_number (filedes);
 }
 
 struct scm *
 open_input_string (struct scm *string)
 {
-  struct scm *port = make_string_port (string);
-  g_ports = cons (port, g_ports);
-  return port;
+  return make_string_port (string);
+}
+
+struct scm *
+open_output_string ()
+{
+  return make_string_output_port ();
+}
+
+struct scm *
+get_output_string (struct scm *port)
+{
+  if (cell_type (port) != TPORT || cell_type (port->cdr->car) != TBYTES)
+    error (cell_symbol_wrong_type_arg, cons (make_string0 ("get-output-string"), port));
+  struct scm *buffer = port->cdr->car;
+  struct scm *count = port->cdr->cdr;
+  return make_string (cell_bytes (buffer), count->value);
+}
+
+struct scm *
+close_port (struct scm *port)
+{
+  if (cell_type (port) == TPORT)
+    port_unmap (port);
+  else if (port->value > 2)
+    close (port->value);
+  return cell_unspecified;
 }
 
 struct scm *
 set_current_input_port (struct scm *port)
 {
   struct scm *prev = current_input_port ();
-  if (port->type == TNUMBER)
+  if (cell_type (port) == TNUMBER)
     {
       int p = port->value;
       if (p != 0)
         __stdin = p;
       else
         __stdin = STDIN;
+      port_set (g_ports, cell_f);
+    }
+  else if (cell_type (port) == TPORT)
+    {
+      __stdin = port->port;
+      port_set (g_ports, port);
     }
-  else if (port->type == TPORT)
-    __stdin = port->port;
   return prev;
 }
 
 struct scm *
 current_output_port ()
 {
+  if (__stdout < 0)
+    return port_ref (__stdout);
   return make_number (__stdout);
 }
 
@@ -287,10 +464,10 @@ open_output_file (struct scm *x)        /*:((arity . n)) */
   struct scm *file_name = car (x);
   x = cdr (x);
   int mode = S_IRUSR | S_IWUSR;
-  if (x->type == TPAIR)
+  if (cell_type (x) == TPAIR)
     {
       struct scm *i = car (x);
-      if (i->type == TNUMBER)
+      if (cell_type (i) == TNUMBER)
         mode = i->value;
     }
   return make_number (mes_open (cell_bytes (file_name->string), O_WRONLY | O_CREAT | O_TRUNC, mode));
@@ -299,10 +476,16 @@ open_output_file (struct scm *x)        /*:((arity . n)) */
 struct scm *
 set_current_output_port (struct scm *port)
 {
-  if (port->value != 0)
+  if (cell_type (port) == TPORT)
+    __stdout = port->port;
+  else if (port->value != 0)
     __stdout = port->value;
   else
     __stdout = STDOUT;
+  if (cell_type (port) == TPORT)
+    port_set (g_ports->cdr, port);
+  else
+    port_set (g_ports->cdr, cell_f);
   return current_output_port ();
 }
 
@@ -326,6 +509,8 @@ chmod_ (struct scm *file_name, struct scm *mode)        /*:((name . "chmod")) */
 struct scm *
 isatty_p (struct scm *port)
 {
+  if (cell_type (port) == TPORT)
+    return cell_f;
   if (isatty (port->value) != 0)
     return cell_t;
   return cell_f;
@@ -351,7 +536,7 @@ execl_ (struct scm *file_name, struct scm *args)        /*:((name . "execl")) */
   struct scm *arg;
   while (args != cell_nil)
     {
-      assert_msg (args->car->type == TSTRING, "args->car->type == TSTRING");
+      assert_msg (cell_type (args->car) == TSTRING, "cell_type (args->car) == TSTRING");
       arg = args->car;
       c_argv[i] = cell_bytes (arg->string);
       i = i + 1;
@@ -243,7 +243,7 @@ reader_read_hash (int c, struct scm *a)
     {
       struct scm *x = reader_read_identifier_or_number (readchar ());
       struct scm *msg = make_string0 ("keyword perifx ':' not followed by a symbol: ");
-      if (x->type == TNUMBER)
+      if (cell_type (x) == TNUMBER)
         error (cell_symbol_system_error, cons (msg, x));
       return symbol_to_keyword (x);
     }
@@ -27,12 +27,12 @@
 struct scm *
 frame_printer (struct scm *frame)
 {
-  fdputs ("#<", __stdout);
+  port_puts ("#<", __stdout);
   display_ (struct_ref_ (frame, 2));
-  fdputc (' ', __stdout);
-  fdputs ("procedure: ", __stdout);
+  port_putc (' ', __stdout);
+  port_puts ("procedure: ", __stdout);
   display_ (struct_ref_ (frame, 3));
-  fdputc ('>', __stdout);
+  port_putc ('>', __stdout);
 }
 
 struct scm *
@@ -64,13 +64,13 @@ list_to_cstring (struct scm *list, size_t *size)
 struct scm *
 string_equal_p (struct scm *a, struct scm *b)   /*:((name . "string=?")) */
 {
-  if (!((a->type == TSTRING && b->type == TSTRING) || (a->type == TKEYWORD || b->type == TKEYWORD)))
+  if (!((cell_type (a) == TSTRING && cell_type (b) == TSTRING) || (cell_type (a) == TKEYWORD || cell_type (b) == TKEYWORD)))
     {
       eputs ("type a: ");
-      eputs (itoa (a->type));
+      eputs (itoa (cell_type (a)));
       eputs ("\n");
       eputs ("type b: ");
-      eputs (itoa (b->type));
+      eputs (itoa (cell_type (b)));
       eputs ("\n");
       eputs ("a= ");
       write_error_ (a);
@@ -78,7 +78,7 @@ string_equal_p (struct scm *a, struct scm *b)   /*:((name . "string=?")) */
       eputs ("b= ");
       write_error_ (b);
       eputs ("\n");
-      assert_msg ((a->type == TSTRING && b->type == TSTRING) || (a->type == TKEYWORD || b->type == TKEYWORD), "(a->type == TSTRING && b->type == TSTRING) || (a->type == TKEYWORD || b->type == TKEYWORD)");
+      assert_msg ((cell_type (a) == TSTRING && cell_type (b) == TSTRING) || (cell_type (a) == TKEYWORD || cell_type (b) == TKEYWORD), "(cell_type (a) == TSTRING && cell_type (b) == TSTRING) || (cell_type (a) == TKEYWORD || cell_type (b) == TKEYWORD)");
     }
   if (a == b)
     return cell_t;
@@ -151,8 +151,11 @@ cstring_to_list (char const *s)
 struct scm *
 cstring_to_symbol (char const *s)
 {
-  struct scm *string = make_string0 (s);
-  return string_to_symbol (string);
+  size_t length = strlen (s);
+  struct scm *x = hash_ref_bytes (g_symbols, s, length);
+  if (x == cell_f)
+    x = make_symbol (make_string (s, length));
+  return x;
 }
 
 struct scm *
@@ -173,10 +176,10 @@ struct scm *
 read_string (struct scm *port)          /*:((arity . n)) */
 {
   int fd = __stdin;
-  if (port->type == TPAIR)
+  if (cell_type (port) == TPAIR)
     {
       struct scm *p = car (port);
-      if (p->type == TNUMBER)
+      if (cell_type (p) == TNUMBER)
         __stdin = p->value;
     }
   int c = readchar ();
@@ -204,7 +207,7 @@ string_append (struct scm *x)           /*:((arity . n)) */
   while (x != cell_nil)
     {
       string = x->car;
-      assert_msg (string->type == TSTRING, "string->type == TSTRING");
+      assert_msg (cell_type (string) == TSTRING, "cell_type (string) == TSTRING");
       memcpy (p, cell_bytes (string->string), string->length + 1);
       p = p + string->length;
       size = size + string->length;
@@ -218,15 +221,15 @@ string_append (struct scm *x)           /*:((arity . n)) */
 struct scm *
 string_length (struct scm *string)
 {
-  assert_msg (string->type == TSTRING, "string->type == TSTRING");
+  assert_msg (cell_type (string) == TSTRING, "cell_type (string) == TSTRING");
   return make_number (string->length);
 }
 
 struct scm *
 string_ref (struct scm *str, struct scm *k)
 {
-  assert_msg (str->type == TSTRING, "str->type == TSTRING");
-  assert_msg (k->type == TNUMBER, "k->type == TNUMBER");
+  assert_msg (cell_type (str) == TSTRING, "cell_type (str) == TSTRING");
+  assert_msg (cell_type (k) == TNUMBER, "cell_type (k) == TNUMBER");
   size_t size = str->length;
   size_t i = k->value;
   if (i > size)
@@ -27,7 +27,7 @@ make_struct (struct scm *type, struct scm *fields, struct scm *printer)
   long size = 2 + length__ (fields);
   struct scm *x = alloc (1);
   struct scm *v = alloc (size);
-  x->type = TSTRUCT;
+  set_cell_type (x, TSTRUCT);
   x->length = size;
   x->structure = v;
   copy_cell (v, vector_entry (type));
@@ -50,21 +50,21 @@ make_struct (struct scm *type, struct scm *fields, struct scm *printer)
 struct scm *
 struct_length (struct scm *x)
 {
-  assert_msg (x->type == TSTRUCT, "x->type == TSTRUCT");
+  assert_msg (cell_type (x) == TSTRUCT, "cell_type (x) == TSTRUCT");
   return make_number (x->length);
 }
 
 struct scm *
 struct_ref_ (struct scm *x, long i)
 {
-  assert_msg (x->type == TSTRUCT, "x->type == TSTRUCT");
+  assert_msg (cell_type (x) == TSTRUCT, "cell_type (x) == TSTRUCT");
   assert_msg (i < x->length, "i < x->length");
   struct scm *e = cell_ref (x->structure, i);
-  if (e->type == TREF)
+  if (cell_type (e) == TREF)
     e = e->ref;
-  if (e->type == TCHAR)
+  if (cell_type (e) == TCHAR)
     e = make_char (e->value);
-  if (e->type == TNUMBER)
+  if (cell_type (e) == TNUMBER)
     e = make_number (e->value);
   return e;
 }
@@ -72,9 +72,11 @@ struct_ref_ (struct scm *x, long i)
 struct scm *
 struct_set_x_ (struct scm *x, long i, struct scm *e)
 {
-  assert_msg (x->type == TSTRUCT, "x->type == TSTRUCT");
+  assert_msg (cell_type (x) == TSTRUCT, "cell_type (x) == TSTRUCT");
   assert_msg (i < x->length, "i < x->length");
-  copy_cell (cell_ref (x->structure, i), vector_entry (e));
+  struct scm *v = cell_ref (x->structure, i);
+  copy_cell (v, vector_entry (e));
+  gc_write_barrier (v);
   return cell_unspecified;
 }
 
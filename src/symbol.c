@@ -36,7 +36,7 @@
 struct scm *
 init_symbol (struct scm *x, long type, char const *name)
 {
-  x->type = type;
+  set_cell_type (x, type);
   if (g_symbols == 0)
     g_free = g_free + M2_CELL_SIZE;
   else
@@ -64,7 +64,11 @@ init_symbols_ ()                  /*:((internal)) */
   cell_unspecified = init_symbol (g_symbol, TSPECIAL, "*unspecified*");
   cell_closure = init_symbol (g_symbol, TSPECIAL, "*closure*");
   cell_circular = init_symbol (g_symbol, TSPECIAL, "*circular*");
+  cell_cache_end = init_symbol (g_symbol, TSPECIAL, "*cache-end*");
+  cell_cache_form = init_symbol (g_symbol, TSPECIAL, "*cache-form*");
+  cell_cache_source = init_symbol (g_symbol, TSPECIAL, "*cache-source*");
 
+  /* Keep in sync with the VM_* opcodes in eval-apply.c.  */
   cell_vm_apply = init_symbol (g_symbol, TSPECIAL, "core:apply");
   cell_vm_apply2 = init_symbol (g_symbol, TSPECIAL, "*vm-apply2*");
   cell_vm_begin = init_symbol (g_symbol, TSPECIAL, "*vm-begin*");
@@ -76,13 +80,18 @@ init_symbols_ ()                  /*:((internal)) */
   cell_vm_begin_primitive_load = init_symbol (g_symbol, TSPECIAL, "*vm:core:begin-primitive-load*");
   cell_vm_begin_read_input_file = init_symbol (g_symbol, TSPECIAL, "*vm-begin-read-input-file*");
   cell_vm_call_with_current_continuation2 = init_symbol (g_symbol, TSPECIAL, "*vm-call-with-current-continuation2*");
+  cell_vm_call_with_escape_continuation2 = init_symbol (g_symbol, TSPECIAL, "*vm-call-with-escape-continuation2*");
   cell_vm_call_with_values2 = init_symbol (g_symbol, TSPECIAL, "*vm-call-with-values2*");
   cell_vm_eval = init_symbol (g_symbol, TSPECIAL, "core:eval-expanded");
   cell_vm_eval2 = init_symbol (g_symbol, TSPECIAL, "*vm-eval2*");
+  cell_vm_eval_and = init_symbol (g_symbol, TSPECIAL, "*vm-eval-and*");
+  cell_vm_eval_case = init_symbol (g_symbol, TSPECIAL, "*vm-eval-case*");
   cell_vm_eval_check_func = init_symbol (g_symbol, TSPECIAL, "*vm-eval-check-func*");
+  cell_vm_eval_cond = init_symbol (g_symbol, TSPECIAL, "*vm-eval-cond*");
   cell_vm_eval_define = init_symbol (g_symbol, TSPECIAL, "*vm-eval-define*");
   cell_vm_eval_macro_expand_eval = init_symbol (g_symbol, TSPECIAL, "*vm:eval-macro-expand-eval*");
   cell_vm_eval_macro_expand_expand = init_symbol (g_symbol, TSPECIAL, "*vm:eval-macro-expand-expand*");
+  cell_vm_eval_or = init_symbol (g_symbol, TSPECIAL, "*vm-eval-or*");
   cell_vm_eval_pmatch_car = init_symbol (g_symbol, TSPECIAL, "*vm-eval-pmatch-car*");
   cell_vm_eval_pmatch_cdr = init_symbol (g_symbol, TSPECIAL, "*vm-eval-pmatch-cdr*");
   cell_vm_eval_set_x = init_symbol (g_symbol, TSPECIAL, "*vm-eval-set!*");
@@ -93,6 +102,8 @@ init_symbols_ ()                  /*:((internal)) */
   cell_vm_if_expr = init_symbol (g_symbol, TSPECIAL, "*vm-if-expr*");
   cell_vm_macro_expand = init_symbol (g_symbol, TSPECIAL, "core:macro-expand");
   cell_vm_macro_expand_car = init_symbol (g_symbol, TSPECIAL, "*vm:core:macro-expand-car*");
+  cell_vm_macro_expand_case = init_symbol (g_symbol, TSPECIAL, "*vm:core:macro-expand-case*");
+  cell_vm_macro_expand_case_clause = init_symbol (g_symbol, TSPECIAL, "*vm:core:macro-expand-case-clause*");
   cell_vm_macro_expand_cdr = init_symbol (g_symbol, TSPECIAL, "*vm:macro-expand-cdr*");
   cell_vm_macro_expand_define = init_symbol (g_symbol, TSPECIAL, "*vm:core:macro-expand-define*");
   cell_vm_macro_expand_define_macro = init_symbol (g_symbol, TSPECIAL, "*vm:core:macro-expand-define-macro*");
@@ -114,12 +125,17 @@ init_symbols_ ()                  /*:((internal)) */
   cell_symbol_unsyntax = init_symbol (g_symbol, TSYMBOL, "unsyntax");
   cell_symbol_unsyntax_splicing = init_symbol (g_symbol, TSYMBOL, "unsyntax-splicing");
   cell_symbol_set_x = init_symbol (g_symbol, TSYMBOL, "set!");
+  cell_symbol_and = init_symbol (g_symbol, TSYMBOL, "and");
+  cell_symbol_or = init_symbol (g_symbol, TSYMBOL, "or");
+  cell_symbol_cond = init_symbol (g_symbol, TSYMBOL, "cond");
+  cell_symbol_case = init_symbol (g_symbol, TSYMBOL, "case");
   cell_symbol_sc_expand = init_symbol (g_symbol, TSYMBOL, "sc-expand");
   cell_symbol_macro_expand = init_symbol (g_symbol, TSYMBOL, "macro-expand");
   cell_symbol_portable_macro_expand = init_symbol (g_symbol, TSYMBOL, "portable-macro-expand");
   cell_symbol_sc_expander_alist = init_symbol (g_symbol, TSYMBOL, "*sc-expander-alist*");
   cell_symbol_call_with_values = init_symbol (g_symbol, TSYMBOL, "call-with-values");
   cell_symbol_call_with_current_continuation = init_symbol (g_symbol, TSYMBOL, "call-with-current-continuation");
+  cell_symbol_call_with_escape_continuation = init_symbol (g_symbol, TSYMBOL, "call-with-escape-continuation");
   cell_symbol_boot_module = init_symbol (g_symbol, TSYMBOL, "boot-module");
   cell_symbol_current_module = init_symbol (g_symbol, TSYMBOL, "current-module");
   cell_symbol_primitive_load = init_symbol (g_symbol, TSYMBOL, "primitive-load");
@@ -134,6 +150,8 @@ init_symbols_ ()                  /*:((internal)) */
   cell_symbol_wrong_type_arg = init_symbol (g_symbol, TSYMBOL, "wrong-type-arg");
 
   cell_symbol_buckets = init_symbol (g_symbol, TSYMBOL, "buckets");
+  cell_symbol_epoch = init_symbol (g_symbol, TSYMBOL, "epoch");
+  cell_symbol_count = init_symbol (g_symbol, TSYMBOL, "count");
   cell_symbol_builtin = init_symbol (g_symbol, TSYMBOL, "<builtin>");
   cell_symbol_frame = init_symbol (g_symbol, TSYMBOL, "<frame>");
   cell_symbol_hashq_table = init_symbol (g_symbol, TSYMBOL, "<hashq-table>");
@@ -170,6 +188,7 @@ init_symbols_ ()                  /*:((internal)) */
   cell_type_variable = init_symbol (g_symbol, TSYMBOL, "<cell:variable>");
   cell_type_vector = init_symbol (g_symbol, TSYMBOL, "<cell:vector>");
   cell_type_broken_heart = init_symbol (g_symbol, TSYMBOL, "<cell:broken-heart>");
+  cell_type_lexical = init_symbol (g_symbol, TSYMBOL, "<cell:lexical>");
 
   cell_symbol_program = init_symbol (g_symbol, TSYMBOL, "%program");
   cell_symbol_test = init_symbol (g_symbol, TSYMBOL, "%%test");
@@ -186,7 +205,8 @@ init_symbols ()                  /*:((internal)) */
   g_symbol_max = g_symbol;
   g_symbols = make_hash_table_ (500);
   init_symbols_ ();
-  g_ports = cell_nil;
+  g_ports = cons (cell_f, cons (cell_f, cons (cell_f, cell_nil)));
+  g_jit_constants = cell_nil;
 
   struct scm *a = cell_nil;
   a = acons (cell_symbol_call_with_values, cell_symbol_call_with_values, a);
@@ -214,6 +234,7 @@ init_symbols ()                  /*:((internal)) */
   a = acons (cell_type_variable, make_number (TVARIABLE), a);
   a = acons (cell_type_vector, make_number (TVECTOR), a);
   a = acons (cell_type_broken_heart, make_number (TBROKEN_HEART), a);
+  a = acons (cell_type_lexical, make_number (TLEXICAL), a);
 
   a = acons (cell_closure, a, a);
 
@@ -46,7 +46,7 @@ test_setup ()
   M0 = cell_zero;
 
   memset (g_arena + sizeof (struct scm), 0, ARENA_SIZE * sizeof (struct scm));
-  cell_zero->type = TCHAR;
+  set_cell_type (cell_zero, TCHAR);
   cell_zero->value = 'c';
   g_free = cell_f;
 }
@@ -55,7 +55,7 @@ void
 print_arena (long length)
 {
   struct scm *v = cell_arena;
-  v->type = TVECTOR;
+  set_cell_type (v, TVECTOR);
   v->length = length;
   eputs ("arena["); eputs (ntoab (g_cells, 16, 0)); eputs ("]: "); write_ (v); eputs ("\n");
 }
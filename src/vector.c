@@ -34,7 +34,7 @@ make_vector_ (long k, struct scm *e)
 {
   struct scm *x = alloc (1);
   struct scm *v = alloc (k);
-  x->type = TVECTOR;
+  set_cell_type (x, TVECTOR);
   x->length = k;
   x->vector = v;
   long i;
@@ -60,21 +60,21 @@ make_vector (struct scm *x)               /*:((arity . n)) */
 struct scm *
 vector_length (struct scm *x)
 {
-  assert_msg (x->type == TVECTOR, "x->type == TVECTOR");
+  assert_msg (cell_type (x) == TVECTOR, "cell_type (x) == TVECTOR");
   return make_number (x->length);
 }
 
 struct scm *
 vector_ref_ (struct scm *x, long i)
 {
-  assert_msg (x->type == TVECTOR, "x->type == TVECTOR");
+  assert_msg (cell_type (x) == TVECTOR, "cell_type (x) == TVECTOR");
   assert_msg (i < x->length, "i < x->length");
   struct scm *e = cell_ref (x->vector, i);
-  if (e->type == TREF)
+  if (cell_type (e) == TREF)
     e = e->ref;
-  if (e->type == TCHAR)
+  if (cell_type (e) == TCHAR)
     e = make_char (e->value);
-  if (e->type == TNUMBER)
+  if (cell_type (e) == TNUMBER)
     e = make_number (e->value);
   return e;
 }
@@ -88,7 +88,7 @@ vector_ref (struct scm *x, struct scm *i)
 struct scm *
 vector_entry (struct scm *x)
 {
-  if (x->type != TCHAR && x->type != TNUMBER)
+  if (cell_type (x) != TCHAR && cell_type (x) != TNUMBER)
     x = make_ref (x);
   return x;
 }
@@ -96,9 +96,11 @@ vector_entry (struct scm *x)
 struct scm *
 vector_set_x_ (struct scm *x, long i, struct scm *e)
 {
-  assert_msg (x->type == TVECTOR, "x->type == TVECTOR");
+  assert_msg (cell_type (x) == TVECTOR, "cell_type (x) == TVECTOR");
   assert_msg (i < x->length, "i < x->length");
-  copy_cell (cell_ref (x->vector, i), vector_entry (e));
+  struct scm *v = cell_ref (x->vector, i);
+  copy_cell (v, vector_entry (e));
+  gc_write_barrier (v);
   return cell_unspecified;
 }
 
@@ -131,7 +133,7 @@ vector_to_list (struct scm *v)
   for (i = v->length; i; i = i - 1)
     {
       e = cell_ref (v->vector, i - 1);
-      if (e->type == TREF)
+      if (cell_type (e) == TREF)
         e = e->ref;
       x = cons (e, x);
     }